@@ -0,0 +1,54 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include "all_duplicates.hpp"
+#include "functional_graph.hpp"
+#include "random.hpp"
+#include "workload.hpp"
+
+template <class F>
+double seconds(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Crossover between the all-duplicates modes, the plain in-degree count of
+// analyze_functional_graph(), and one pointer chase, which finds a single
+// duplicate only. "random" has about n/4 duplicates, "rho" is a generated
+// array with a single one and a rho over half the nodes.
+int main(int argc, char* argv[])
+{
+    unsigned max_log = argc > 1 ? std::stoul(argv[1]) : 28;
+    std::cout << "input, n, bitset s, histogram s, in-degree s, chase s, duplicates\n";
+    for (const char* input: {"random", "rho"})
+    {
+        for (unsigned log = 16; log <= max_log; log += 2)
+        {
+            size_t n = size_t(1) << log;
+            std::vector<uint32_t> v(n);
+            if (input == std::string("random"))
+            {
+                fill_with_random<uint32_t>(v, 1, n - 1, log);
+            }
+            else
+            {
+                v = generate_workload<uint32_t>({.n = n, .mu = n/4, .lambda = n/4, .seed = log});
+            }
+
+            // The volatile stores keep the pure calls inside the timed region.
+            volatile size_t found = 0, sink = 0;
+            double bitset = seconds([&]{ found = find_all_duplicates_bitset(v).size(); });
+            double histogram = seconds([&]{ sink = find_all_duplicates_histogram(v).size(); });
+            double in_degree = seconds([&]{ sink = count_duplicates(v).size(); });
+            double chase = seconds([&]{ sink = detect_cycle<Brent>(v).entry; });
+            std::cout << input << ", " << n << ", " << bitset << ", " << histogram << ", " << in_degree
+                      << ", " << chase << ", " << found << '\n';
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include "cycle_detection.hpp"
+
+// Builds an array whose rho from index 0 has exactly the given tail and cycle
+// length; nodes off the rho point to themselves.
+std::vector<uint32_t> make_rho(size_t n, size_t mu, size_t lambda, std::mt19937_64& gen)
+{
+    std::vector<uint32_t> order(n - 1);
+    std::iota(order.begin(), order.end(), 1);
+    std::shuffle(order.begin(), order.end(), gen);
+    order.insert(order.begin(), 0);
+
+    std::vector<uint32_t> v(n);
+    std::iota(v.begin(), v.end(), 0);
+    for (size_t i = 0; i + 1 < mu + lambda; i++)
+    {
+        v[order[i]] = order[i + 1];
+    }
+    v[order[mu + lambda - 1]] = order[mu];
+    return v;
+}
+
+template <class Engine>
+void run(const char* name, const std::vector<uint32_t>& v)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto r = detect_cycle<Engine>(v);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << name << ": " << elapsed.count() << " s, "
+              << r.evaluations << " lookups, "
+              << elapsed.count()*1e9/r.evaluations << " ns/lookup\n";
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? std::stoull(argv[1]) : size_t(1) << 27;
+    std::mt19937_64 gen(42);
+    std::cout << "n = " << n << " (" << n*sizeof(uint32_t)/(1 << 20) << " MiB)\n";
+
+    struct Shape { const char* name; size_t mu, lambda; };
+    for (Shape s: {Shape{"long tail, short cycle", n/4, 8},
+                   Shape{"balanced", n/8, n/8},
+                   Shape{"short tail, long cycle", 8, n/4}})
+    {
+        auto v = make_rho(n, s.mu, s.lambda, gen);
+        std::cout << s.name << " (mu = " << s.mu << ", lambda = " << s.lambda << ")\n";
+        run<Floyd>("Floyd   ", v);
+        run<Brent>("Brent   ", v);
+        run<Gosper>("Gosper  ", v);
+        run<Nivasch>("Nivasch ", v);
+        run<Trail<>>("Trail<16>", v);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "analysis_server.hpp"
+#include "random.hpp"
+
+// daemon_queries <socket> [queries] [pipeline depth] [array]
+// Sends rho queries for random start nodes with up to `depth` outstanding
+// and reports the sustained rate.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <socket> [queries] [depth] [array]\n";
+        return 1;
+    }
+    size_t queries = argc > 2 ? std::stoull(argv[2]) : 1000000;
+    size_t depth = argc > 3 ? std::stoull(argv[3]) : 64;
+    uint16_t array = argc > 4 ? std::stoul(argv[4]) : 0;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "Can't connect to " << argv[1] << '\n';
+        return 1;
+    }
+
+    auto exchange = [&](std::vector<QueryRequest>& requests, std::vector<QueryResponse>& responses)
+    {
+        ::send(fd, requests.data(), requests.size()*sizeof(QueryRequest), 0);
+        responses.resize(requests.size());
+        size_t bytes = responses.size()*sizeof(QueryResponse), got = 0;
+        while (got < bytes)
+        {
+            ssize_t n = ::read(fd, reinterpret_cast<char*>(responses.data()) + got, bytes - got);
+            if (n <= 0)
+            {
+                throw std::runtime_error("Daemon closed the connection");
+            }
+            got += n;
+        }
+    };
+
+    std::vector<QueryRequest> requests{{0, static_cast<uint16_t>(QueryOp::size), array, 0}};
+    std::vector<QueryResponse> responses;
+    exchange(requests, responses);
+    if (responses[0].status != static_cast<uint16_t>(QueryStatus::ok))
+    {
+        std::cerr << "No array " << array << '\n';
+        return 1;
+    }
+    uint64_t n = responses[0].entry;
+
+    RandomGen<uint64_t> start(0, n - 1, 1);
+    size_t failed = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t sent = 0; sent < queries; sent += depth)
+    {
+        requests.resize(std::min(depth, queries - sent));
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            requests[i] = {static_cast<uint32_t>(sent + i), static_cast<uint16_t>(QueryOp::rho), array, start()};
+        }
+        exchange(requests, responses);
+        for (const auto& r: responses)
+        {
+            failed += r.status != static_cast<uint16_t>(QueryStatus::ok);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    std::cout << queries << " queries, depth " << depth << ": " << elapsed.count() << " s, "
+              << queries/elapsed.count() << " queries/s, " << failed << " failed\n";
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include "pollard_rho.hpp"
+
+template <class U>
+std::vector<U> trial_division(U n)
+{
+    std::vector<U> factors;
+    for (U p = 2; p*p <= n; p += 1 + (p > 2))
+    {
+        while (n % p == 0)
+        {
+            factors.push_back(p);
+            n /= p;
+        }
+    }
+    if (n > 1)
+    {
+        factors.push_back(n);
+    }
+    return factors;
+}
+
+uint64_t random_prime(unsigned bits, std::mt19937_64& gen)
+{
+    uint64_t x = (gen() >> (65 - bits)) | (uint64_t(1) << (bits - 1));
+    while (!is_prime(x))
+    {
+        x++;
+    }
+    return x;
+}
+
+template <class U, class Factorize>
+double time_per_call(const std::vector<U>& inputs, Factorize factorize_one)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t check = 0;
+    for (U n: inputs)
+    {
+        check += factorize_one(n).size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (check < inputs.size())
+    {
+        std::cout << "wrong factor count\n";
+    }
+    return elapsed.count()/inputs.size();
+}
+
+int main(int argc, char* argv[])
+{
+    size_t threads = argc > 1 ? std::stoull(argv[1]) : std::thread::hardware_concurrency();
+    std::mt19937_64 gen(42);
+    std::cout << "threads = " << threads << "\n";
+
+    // Semiprimes p*q with equal-sized factors are the worst case for both.
+    for (unsigned bits: {16u, 20u, 24u, 28u, 31u})
+    {
+        size_t count = bits <= 24 ? 200 : 10;
+        std::vector<uint64_t> inputs;
+        for (size_t i = 0; i < count; i++)
+        {
+            inputs.push_back(random_prime(bits, gen)*random_prime(bits, gen));
+        }
+        double rho = time_per_call(inputs, [&](uint64_t n){ return factorize(n, threads); });
+        double trial = time_per_call(inputs, [](uint64_t n){ return trial_division(n); });
+        std::cout << bits << "-bit factors: rho " << rho*1e6 << " us, trial division "
+                  << trial*1e6 << " us, " << trial/rho << "x\n";
+    }
+
+    // 128-bit moduli are out of reach for trial division.
+    for (unsigned bits: {32u, 40u, 48u})
+    {
+        std::vector<u128> inputs;
+        for (size_t i = 0; i < 10; i++)
+        {
+            inputs.push_back(u128(random_prime(bits, gen))*random_prime(bits, gen)*random_prime(48, gen));
+        }
+        double rho = time_per_call(inputs, [&](u128 n){ return factorize(n, threads); });
+        std::cout << "128-bit, factors of " << bits << ", " << bits << " and 48 bits: rho " << rho*1e3 << " ms\n";
+    }
+    return 0;
+}
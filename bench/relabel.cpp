@@ -0,0 +1,118 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "relabel.hpp"
+#include "workload.hpp"
+
+// Hardware cache-miss counter of this thread; reads as -1 where perf events
+// are not available (containers, perf_event_paranoid).
+class MissCounter
+{
+public:
+    MissCounter()
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~MissCounter()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    void start()
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    int64_t stop()
+    {
+        int64_t count = -1;
+        if (fd < 0 or ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) != 0 or ::read(fd, &count, sizeof(count)) != sizeof(count))
+        {
+            return -1;
+        }
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+// relabel [n] [queries]
+// Chases from 0 and from random starts on a generated array, in the original
+// labels and after LocalityRelabeling, and reports time and cache misses.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? std::stoull(argv[1]) : size_t(1) << 25;
+    size_t queries = argc > 2 ? std::stoull(argv[2]) : 16;
+    std::cout << "n = " << n << " (" << n*sizeof(uint32_t)/(1 << 20) << " MiB)\n";
+
+    WorkloadSpec spec{n, n/8, n/8};
+    spec.components = 64;
+    spec.other_lambda = 1024;
+    spec.duplicates = 1 + n/16;
+    spec.seed = 7;
+    std::vector<uint32_t> v = generate_workload<uint32_t>(spec);
+
+    auto begin = std::chrono::steady_clock::now();
+    RelabeledArray<uint32_t> local(v);
+    std::chrono::duration<double> build = std::chrono::steady_clock::now() - begin;
+    std::cout << "relabeling: " << build.count() << " s\n";
+
+    std::vector<uint32_t> starts{0};
+    RandomGen<uint32_t> gen(0, n - 1, 1);
+    while (starts.size() < queries)
+    {
+        starts.push_back(gen());
+    }
+
+    MissCounter misses;
+    auto run = [&](const char* name, auto chase)
+    {
+        size_t lookups = 0;
+        uint64_t check = 0;
+        misses.start();
+        auto begin = std::chrono::steady_clock::now();
+        for (uint32_t s: starts)
+        {
+            auto r = chase(s);
+            lookups += r.evaluations;
+            check += r.entry + r.mu + r.lambda;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        int64_t missed = misses.stop();
+        std::cout << "  " << name << ": " << elapsed.count() << " s, "
+                  << elapsed.count()*1e9/lookups << " ns/lookup, ";
+        if (missed >= 0)
+        {
+            std::cout << double(missed)/lookups << " misses/lookup";
+        }
+        else
+        {
+            std::cout << "misses n/a";
+        }
+        std::cout << " (check " << check << ")\n";
+    };
+    std::cout << starts.size() << " chases with Brent\n";
+    run("original ", [&](uint32_t s){ return detect_cycle<Brent>(v, s); });
+    run("relabeled", [&](uint32_t s){ return local.detect_cycle<Brent>(s); });
+    return 0;
+}
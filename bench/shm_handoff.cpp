@@ -0,0 +1,56 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "shared_array.hpp"
+#include "workload.hpp"
+#include "text_parser.hpp"
+
+// shm_handoff [n] [text file]
+// Time from a producer holding an array to it holding the answer, through a
+// shared segment versus through a text file that the analyzer re-parses.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    std::string text_path = argc > 2 ? argv[2] : "/tmp/shm_handoff.txt";
+    std::string name = "/tah_shm_handoff_" + std::to_string(::getpid());
+
+    // Fork before any pool thread exists; the child is the analyzer process.
+    SharedArrayProducer producer(name, n, sizeof(uint32_t));
+    pid_t child = ::fork();
+    if (child == 0)
+    {
+        SharedArrayAnalyzer analyzer(name);
+        ::_exit(analyzer.serve_once(std::chrono::seconds(600)) ? 0 : 1);
+    }
+
+    // A real producer builds the array in the segment; here it is copied in
+    // up front so both paths start from the same in-memory array.
+    WorkloadSpec spec{n, n/3, n/3};
+    spec.duplicates = 1;
+    std::vector<uint32_t> v = generate_workload<uint32_t>(spec);
+    std::copy(v.begin(), v.end(), producer.data<uint32_t>().begin());
+
+    auto begin = std::chrono::steady_clock::now();
+    producer.publish();
+    RhoResult<uint64_t> shared = producer.wait_result();
+    std::chrono::duration<double> shm_time = std::chrono::steady_clock::now() - begin;
+    ::waitpid(child, nullptr, 0);
+
+    begin = std::chrono::steady_clock::now();
+    write_text(text_path, v);
+    auto parsed = load_text_indices<uint32_t>(text_path);
+    validate_indices(parsed);
+    RhoResult<uint32_t> text = detect_cycle<Brent>(parsed);
+    std::chrono::duration<double> text_time = std::chrono::steady_clock::now() - begin;
+    ::unlink(text_path.c_str());
+
+    std::cout << "n = " << n << ", entry " << shared.entry << (shared.entry == text.entry ? "" : " MISMATCH") << '\n'
+              << "shared memory: " << shm_time.count() << " s\n"
+              << "text file:     " << text_time.count() << " s (" << text_time.count()/shm_time.count() << "x)\n";
+    return shared.entry == text.entry ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <vector>
+#include <concepts>
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "cycle_detection.hpp"
+#include "work_stealing_pool.hpp"
+
+// Every value that occurs more than once, with its multiplicity, by value.
+// Unlike find_duplicates() this needs no precondition on the input beyond all
+// entries lying in [0, n).
+template <std::integral I>
+using Duplicates = std::vector<std::pair<I, size_t>>;
+
+// std::popcount becomes a libgcc call unless the target has a popcount
+// instruction enabled; this inline version keeps the hot loop call-free.
+inline unsigned popcount64(uint64_t x)
+{
+    x -= (x >> 1) & 0x5555555555555555;
+    x = (x & 0x3333333333333333) + ((x >> 2) & 0x3333333333333333);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0f;
+    return (x*0x0101010101010101) >> 56;
+}
+
+// Bit planes for "seen", "seen twice" and "seen three or more times", kept
+// side by side with a rank word so one 32-byte line per 64 values holds all
+// the state: 4 bits per value where an in-degree array needs 32 or 64.
+// Values seen exactly twice are done after the first pass; only the (much
+// rarer) 3+ values need a second pass, counting into a dense array indexed
+// by the rank of their bit.
+template <IndexArray A>
+Duplicates<typename A::value_type> find_all_duplicates_bitset(const A& v)
+{
+    using I = typename A::value_type;
+    struct alignas(32) Word
+    {
+        uint64_t seen = 0, twice = 0, more = 0;
+        uint64_t rank = 0;   // 3+ values below this word
+    };
+    const size_t n = v.size();
+    std::vector<Word> words((n + 63)/64);
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t x = static_cast<size_t>(v[i]);
+        uint64_t bit = uint64_t(1) << (x % 64);
+        Word& w = words[x/64];
+        w.more |= w.twice & bit;
+        w.twice |= w.seen & bit;
+        w.seen |= bit;
+    }
+
+    size_t total = 0, repeated = 0;
+    for (Word& w: words)
+    {
+        w.rank = total;
+        total += popcount64(w.more);
+        repeated += popcount64(w.twice);
+    }
+
+    auto count = [&]<class Count>(Count)
+    {
+        // Other values land in a spare last slot instead of behind a branch,
+        // which would mispredict often.
+        std::vector<Count> counts(total + 1);
+        if (total > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                size_t x = static_cast<size_t>(v[i]);
+                uint64_t bit = uint64_t(1) << (x % 64);
+                const Word& w = words[x/64];
+                size_t slot = w.rank + popcount64(w.more & (bit - 1));
+                counts[w.more & bit ? slot : total]++;
+            }
+        }
+
+        Duplicates<I> result;
+        result.reserve(repeated);
+        for (size_t w = 0, k = 0; w < words.size(); w++)
+        {
+            for (uint64_t bits = words[w].twice; bits; bits &= bits - 1)
+            {
+                uint64_t bit = bits & -bits;
+                size_t multiplicity = words[w].more & bit ? counts[k++] : 2;
+                result.emplace_back(static_cast<I>(64*w + std::countr_zero(bits)), multiplicity);
+            }
+        }
+        return result;
+    };
+    // Narrow counters keep the random second pass in cache longer.
+    return n <= UINT32_MAX ? count(uint32_t()) : count(uint64_t());
+}
+
+// Parallel radix partition on the high bits of each value into buckets of
+// 2^bucket_bits values, then one cache-sized histogram per bucket. Both
+// passes stream over memory, at the cost of one n-entry scratch copy.
+template <IndexArray A>
+Duplicates<typename A::value_type> find_all_duplicates_histogram(const A& v,
+                                                                 WorkStealingPool& pool = default_pool(),
+                                                                 unsigned bucket_bits = 15)
+{
+    using I = typename A::value_type;
+    const size_t n = v.size();
+    const size_t buckets = (n >> bucket_bits) + 1;
+    // A few chunks per thread; every chunk keeps its own bucket offsets.
+    const size_t grain = std::max(size_t(1) << 20, n/(4*pool.size()) + 1);
+    const size_t chunks = (n + grain - 1)/grain;
+
+    // offsets[c*buckets + b]: where chunk c scatters its first value of bucket b.
+    std::vector<size_t> offsets(chunks*buckets);
+    pool.parallel_for(0, chunks, 1, [&](size_t lo, size_t hi)
+    {
+        for (size_t c = lo; c < hi; c++)
+        {
+            size_t* count = offsets.data() + c*buckets;
+            for (size_t i = c*grain; i < std::min(n, (c + 1)*grain); i++)
+            {
+                count[static_cast<size_t>(v[i]) >> bucket_bits]++;
+            }
+        }
+    });
+    std::vector<size_t> bucket_begin(buckets + 1);
+    size_t sum = 0;
+    for (size_t b = 0; b < buckets; b++)
+    {
+        bucket_begin[b] = sum;
+        for (size_t c = 0; c < chunks; c++)
+        {
+            size_t count = offsets[c*buckets + b];
+            offsets[c*buckets + b] = sum;
+            sum += count;
+        }
+    }
+    bucket_begin[buckets] = sum;
+
+    std::vector<I> partitioned(n);
+    pool.parallel_for(0, chunks, 1, [&](size_t lo, size_t hi)
+    {
+        for (size_t c = lo; c < hi; c++)
+        {
+            size_t* next = offsets.data() + c*buckets;
+            for (size_t i = c*grain; i < std::min(n, (c + 1)*grain); i++)
+            {
+                partitioned[next[static_cast<size_t>(v[i]) >> bucket_bits]++] = v[i];
+            }
+        }
+    });
+
+    // One histogram per task, allocated once; the tasks pull buckets from a
+    // shared counter, since skewed inputs make bucket sizes uneven. A bucket
+    // scan leaves its histogram zeroed for the next one.
+    std::vector<Duplicates<I>> found(buckets);
+    std::atomic<size_t> next_bucket = 0;
+    auto scan_buckets = [&]<class Count>(Count)
+    {
+        pool.parallel_for(0, std::min(buckets, pool.size()), 1, [&](size_t, size_t)
+        {
+            std::vector<Count> histogram(size_t(1) << bucket_bits);
+            for (size_t b = next_bucket++; b < buckets; b = next_bucket++)
+            {
+                const size_t first = b << bucket_bits;
+                for (size_t i = bucket_begin[b]; i < bucket_begin[b + 1]; i++)
+                {
+                    histogram[static_cast<size_t>(partitioned[i]) - first]++;
+                }
+                for (size_t x = 0; x < histogram.size(); x++)
+                {
+                    if (histogram[x] > 1)
+                    {
+                        found[b].emplace_back(static_cast<I>(first + x), histogram[x]);
+                    }
+                    histogram[x] = 0;
+                }
+            }
+        });
+    };
+    // 32-bit counters halve the histogram, keeping it cache-sized.
+    n <= UINT32_MAX ? scan_buckets(uint32_t()) : scan_buckets(uint64_t());
+
+    Duplicates<I> result;
+    for (const auto& part: found)
+    {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    return result;
+}
+
+enum class DuplicateMode
+{
+    automatic,
+    bitset,
+    histogram
+};
+
+// Up to here the 4 bits per value (8 MiB) stay in cache and the bitset is
+// fastest. Beyond it every bitset access misses, and the streaming histogram
+// wins even on one core (see bench/all_duplicates.cpp).
+constexpr size_t bitset_duplicates_limit = size_t(1) << 24;
+
+template <IndexArray A>
+Duplicates<typename A::value_type> find_all_duplicates(const A& v, DuplicateMode mode = DuplicateMode::automatic,
+                                                       WorkStealingPool& pool = default_pool())
+{
+    if (mode == DuplicateMode::automatic)
+    {
+        mode = v.size() <= bitset_duplicates_limit ? DuplicateMode::bitset : DuplicateMode::histogram;
+    }
+    return mode == DuplicateMode::bitset ? find_all_duplicates_bitset(v) : find_all_duplicates_histogram(v, pool);
+}
@@ -0,0 +1,464 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <variant>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "rho_index.hpp"
+#include "binary_format.hpp"
+#include "text_parser.hpp"
+#include "validation.hpp"
+#include "work_stealing_pool.hpp"
+
+// Wire format: fixed-size little-endian frames. A client may pipeline any
+// number of requests; every response echoes the request id, and responses to
+// one connection can arrive in any order.
+struct QueryRequest
+{
+    uint32_t id;
+    uint16_t op;        // QueryOp
+    uint16_t array;     // position of the array on the daemon's command line
+    uint64_t start;     // start node for QueryOp::rho
+};
+static_assert(sizeof(QueryRequest) == 16);
+
+struct QueryResponse
+{
+    uint32_t id;
+    uint16_t status;    // QueryStatus
+    uint16_t reserved;
+    uint64_t entry;     // QueryOp::size: number of nodes
+    uint64_t tail;
+    uint64_t cycle;
+};
+static_assert(sizeof(QueryResponse) == 32);
+
+enum class QueryOp : uint16_t
+{
+    size = 1,
+    rho = 2     // entry, tail and cycle length of the rho from start;
+                // start 0 gives the find_duplicates() answer
+};
+
+enum class QueryStatus : uint16_t
+{
+    ok = 0,
+    bad_array,
+    bad_start,
+    bad_op
+};
+
+// An input file reduced to its RhoIndex, so any query is two lookups.
+class AnalyzedArray
+{
+public:
+    explicit AnalyzedArray(const std::string& path)
+    {
+        auto build = [this](const auto& v)
+        {
+            validate_indices(v);
+            if (v.size() <= UINT32_MAX)
+            {
+                index = RhoIndex<uint32_t>(std::vector<uint32_t>(v.begin(), v.end()));
+            }
+            else
+            {
+                index = RhoIndex<uint64_t>(std::vector<uint64_t>(v.begin(), v.end()));
+            }
+        };
+        if (is_binary_file(path))
+        {
+            MappedArray mapped(path);
+            if (!mapped.verify_checksum())
+            {
+                throw std::runtime_error(path + " fails its checksum");
+            }
+            std::visit(build, mapped.view());
+        }
+        else
+        {
+            build(load_text_indices<int64_t>(path));
+        }
+    }
+
+    size_t size() const
+    {
+        return std::visit([](const auto& r){ return r.size(); }, index);
+    }
+
+    QueryResponse answer(const QueryRequest& q) const
+    {
+        QueryResponse r{q.id, static_cast<uint16_t>(QueryStatus::ok), 0, 0, 0, 0};
+        if (q.op == static_cast<uint16_t>(QueryOp::size))
+        {
+            r.entry = size();
+        }
+        else if (q.op != static_cast<uint16_t>(QueryOp::rho))
+        {
+            r.status = static_cast<uint16_t>(QueryStatus::bad_op);
+        }
+        else if (q.start >= size())
+        {
+            r.status = static_cast<uint16_t>(QueryStatus::bad_start);
+        }
+        else
+        {
+            std::visit([&](const auto& rho)
+            {
+                using I = decltype(rho.entry(0));
+                I x = static_cast<I>(q.start);
+                r.entry = rho.entry(x);
+                r.tail = rho.tail_length(x);
+                r.cycle = rho.cycle_length(x);
+            }, index);
+        }
+        return r;
+    }
+
+private:
+    std::variant<RhoIndex<uint32_t>, RhoIndex<uint64_t>> index;
+};
+
+// Resident query server on a Unix stream socket. One thread runs an epoll
+// loop that accepts, reads and writes without blocking; every batch of
+// complete requests read from a connection is answered on the worker pool,
+// which appends the responses to the connection and wakes the loop through
+// an eventfd to flush them.
+// A client may shut down its write side after the last request: the
+// connection stays open until every answer is written. While a client lets
+// max_output_bytes of answers pile up unread, its requests are not read.
+class AnalysisServer
+{
+public:
+    AnalysisServer(const std::string& socket_path, std::vector<AnalyzedArray> arrays,
+                   WorkStealingPool& pool = default_pool()):
+        path(socket_path),
+        arrays(std::move(arrays)),
+        pool(pool)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            throw std::invalid_argument("Socket path " + path + " is too long");
+        }
+        std::strcpy(address.sun_path, path.c_str());
+
+        listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ::unlink(path.c_str());
+        if (listener < 0 or epoll < 0 or wakeup < 0 or
+            ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 or
+            ::listen(listener, SOMAXCONN) != 0)
+        {
+            std::string error = std::strerror(errno);
+            close_all();
+            throw std::runtime_error("Can't listen on " + path + ": " + error);
+        }
+        if (!watch(listener, EPOLLIN) or !watch(wakeup, EPOLLIN))
+        {
+            std::string error = std::strerror(errno);
+            close_all();
+            throw std::runtime_error("Can't watch " + path + ": " + error);
+        }
+    }
+
+    static constexpr size_t max_output_bytes = size_t(1) << 22;
+    static constexpr size_t max_pending_batches = 16;
+
+    AnalysisServer(const AnalysisServer&) = delete;
+    AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+    ~AnalysisServer()
+    {
+        // Batches still on the pool use this object.
+        while (in_flight.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+        close_all();
+        ::unlink(path.c_str());
+    }
+
+    // Serves until stop() is called.
+    void run()
+    {
+        epoll_event events[64];
+        while (!stopping.load())
+        {
+            int ready = ::epoll_wait(epoll, events, 64, -1);
+            if (ready < 0 and errno != EINTR)
+            {
+                throw std::runtime_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+            }
+            for (int e = 0; e < ready; e++)
+            {
+                int fd = events[e].data.fd;
+                if (fd == listener)
+                {
+                    accept_all();
+                }
+                else if (fd == wakeup)
+                {
+                    flush_completed();
+                }
+                else if (auto it = connections.find(fd); it != connections.end())
+                {
+                    // EPOLLHUP means both directions are shut, so nothing can
+                    // be delivered any more; a half-close only reads EOF.
+                    auto connection = it->second;
+                    if (events[e].events & (EPOLLHUP | EPOLLERR))
+                    {
+                        drop(connection);
+                        continue;
+                    }
+                    if (events[e].events & EPOLLIN)
+                    {
+                        read_requests(connection);
+                    }
+                    flush(connection);
+                }
+            }
+        }
+    }
+
+    // Async-signal-safe, so it can be called from a SIGTERM handler.
+    void stop()
+    {
+        stopping.store(true);
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(wakeup, &one, sizeof(one));
+    }
+
+private:
+    struct Connection
+    {
+        int fd;
+        std::vector<char> input;
+        std::mutex output_mutex;
+        std::vector<char> output;     // responses not yet written
+        size_t pending = 0;           // batches on the pool; under output_mutex
+        bool closed = false;          // event loop only
+        bool peer_done = false;       // event loop only: read EOF
+        uint32_t interest = EPOLLIN;  // event loop only
+    };
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    bool watch(int fd, uint32_t events, int op = EPOLL_CTL_ADD)
+    {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        return ::epoll_ctl(epoll, op, fd, &event) == 0;
+    }
+
+    void accept_all()
+    {
+        while (true)
+        {
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                return;
+            }
+            if (!watch(fd, EPOLLIN))
+            {
+                ::close(fd);
+                continue;
+            }
+            auto connection = std::make_shared<Connection>();
+            connection->fd = fd;
+            connections.emplace(fd, connection);
+        }
+    }
+
+    // Reads what is available, up to a bounded amount per call, and hands the
+    // complete frames to the pool. Sets peer_done on EOF.
+    void read_requests(const ConnectionPtr& connection)
+    {
+        std::vector<char>& input = connection->input;
+        for (int reads = 0; reads < 16; reads++)
+        {
+            size_t used = input.size();
+            input.resize(used + 64*sizeof(QueryRequest));
+            ssize_t got = ::read(connection->fd, input.data() + used, input.size() - used);
+            input.resize(used + std::max<ssize_t>(got, 0));
+            if (got == 0 or (got < 0 and errno != EAGAIN and errno != EINTR))
+            {
+                connection->peer_done = true;
+                break;
+            }
+            if (got < 0 and errno == EAGAIN)
+            {
+                break;
+            }
+        }
+
+        size_t frames = input.size()/sizeof(QueryRequest);
+        if (frames > 0)
+        {
+            auto batch = std::make_shared<std::vector<QueryRequest>>(frames);
+            std::memcpy(batch->data(), input.data(), frames*sizeof(QueryRequest));
+            input.erase(input.begin(), input.begin() + frames*sizeof(QueryRequest));
+            {
+                std::lock_guard lock(connection->output_mutex);
+                connection->pending++;
+            }
+            in_flight++;
+            pool.submit([this, connection, batch]{ answer(connection, *batch); });
+        }
+    }
+
+    // Runs on a worker.
+    void answer(const ConnectionPtr& connection, const std::vector<QueryRequest>& batch)
+    {
+        std::vector<QueryResponse> responses;
+        responses.reserve(batch.size());
+        for (const QueryRequest& q: batch)
+        {
+            if (q.array >= arrays.size())
+            {
+                responses.push_back({q.id, static_cast<uint16_t>(QueryStatus::bad_array), 0, 0, 0, 0});
+            }
+            else
+            {
+                responses.push_back(arrays[q.array].answer(q));
+            }
+        }
+        {
+            std::lock_guard lock(output_mutex);
+            const char* bytes = reinterpret_cast<const char*>(responses.data());
+            {
+                // Done before the wakeup, so the loop never sees the answers
+                // without also seeing the batch finished.
+                std::lock_guard output_lock(connection->output_mutex);
+                connection->output.insert(connection->output.end(), bytes,
+                                          bytes + responses.size()*sizeof(QueryResponse));
+                connection->pending--;
+            }
+            completed.push_back(connection);
+        }
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(wakeup, &one, sizeof(one));
+        in_flight--;
+    }
+
+    void flush_completed()
+    {
+        uint64_t count;
+        [[maybe_unused]] auto got = ::read(wakeup, &count, sizeof(count));
+        std::vector<ConnectionPtr> ready;
+        {
+            std::lock_guard lock(output_mutex);
+            ready.swap(completed);
+        }
+        for (const auto& connection: ready)
+        {
+            if (!connection->closed)
+            {
+                flush(connection);
+            }
+        }
+    }
+
+    // Writes what the socket takes, then closes a finished half-closed
+    // connection or adjusts what the loop waits for.
+    void flush(const ConnectionPtr& connection)
+    {
+        bool pending_output, busy, finished, failed = false;
+        {
+            std::lock_guard lock(connection->output_mutex);
+            std::vector<char>& output = connection->output;
+            size_t sent = 0;
+            while (sent < output.size())
+            {
+                ssize_t n = ::send(connection->fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+                if (n < 0 and errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    failed = n < 0 and errno != EAGAIN;
+                    break;
+                }
+                sent += n;
+            }
+            output.erase(output.begin(), output.begin() + sent);
+            pending_output = !output.empty();
+            busy = connection->pending >= max_pending_batches or output.size() >= max_output_bytes;
+            // Workers only ever finish batches, so none can add output later.
+            finished = connection->peer_done and !pending_output and connection->pending == 0;
+        }
+        if (failed or finished)
+        {
+            drop(connection);
+            return;
+        }
+        // Only ask for EPOLLOUT while the socket buffer is full, and stop
+        // reading while the client is not taking its answers.
+        uint32_t interest = (pending_output ? uint32_t(EPOLLOUT) : 0u) |
+                            (connection->peer_done or busy ? 0u : uint32_t(EPOLLIN));
+        if (interest != connection->interest)
+        {
+            connection->interest = interest;
+            if (!watch(connection->fd, interest, EPOLL_CTL_MOD))
+            {
+                drop(connection);
+            }
+        }
+    }
+
+    void drop(const ConnectionPtr& connection)
+    {
+        connection->closed = true;
+        ::epoll_ctl(epoll, EPOLL_CTL_DEL, connection->fd, nullptr);
+        ::close(connection->fd);
+        connections.erase(connection->fd);
+    }
+
+    void close_all()
+    {
+        for (auto& [fd, connection]: connections)
+        {
+            connection->closed = true;
+            ::close(fd);
+        }
+        connections.clear();
+        for (int fd: {listener, epoll, wakeup})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+        listener = epoll = wakeup = -1;
+    }
+
+    std::string path;
+    std::vector<AnalyzedArray> arrays;
+    WorkStealingPool& pool;
+    int listener = -1, epoll = -1, wakeup = -1;
+    std::unordered_map<int, ConnectionPtr> connections;
+    std::atomic<bool> stopping = false;
+    std::atomic<size_t> in_flight = 0;     // batches submitted to the pool
+
+    std::mutex output_mutex;
+    std::vector<ConnectionPtr> completed;   // connections with new output
+};
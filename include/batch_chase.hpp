@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <concepts>
+#include <cstddef>
+#include <algorithm>
+
+// find_duplicates() over many independent arrays. Up to `lanes` Floyd chases
+// advance in lockstep, one step per lane per round, so the dependent loads of
+// different arrays are in flight at the same time instead of one after the
+// other. A lane that finishes is refilled with the next pending array.
+// Every array must be non-empty; results[i] == find_duplicates(arrays[i]).
+template <std::integral I>
+std::vector<I> find_duplicates_batch(std::span<const std::vector<I>> arrays, size_t lanes = 16)
+{
+    std::vector<I> results(arrays.size());
+    if (arrays.empty())
+    {
+        return results;
+    }
+    lanes = std::max<size_t>(1, std::min(lanes, arrays.size()));
+
+    struct Lane
+    {
+        const I* v;
+        size_t array;
+        I tortoise, hare;
+        bool locating;
+    };
+    std::vector<Lane> state(lanes);
+
+    size_t next_array = 0, active = 0;
+    auto load = [&](Lane& lane)
+    {
+        const I* v = arrays[next_array].data();
+        lane = {v, next_array, v[0], v[v[0]], false};
+        next_array++;
+    };
+    for (; active < lanes; active++)
+    {
+        load(state[active]);
+    }
+
+    while (active > 0)
+    {
+        for (size_t l = 0; l < active;)
+        {
+            Lane& lane = state[l];
+            const I* v = lane.v;
+            if (!lane.locating)
+            {
+                if (lane.tortoise == lane.hare)
+                {
+                    lane.locating = true;
+                    lane.tortoise = 0;
+                }
+                else
+                {
+                    lane.tortoise = v[lane.tortoise];
+                    lane.hare = v[v[lane.hare]];
+                }
+                l++;
+                continue;
+            }
+
+            if (lane.tortoise != lane.hare)
+            {
+                lane.tortoise = v[lane.tortoise];
+                lane.hare = v[lane.hare];
+                l++;
+                continue;
+            }
+
+            results[lane.array] = lane.hare;
+            if (next_array < arrays.size())
+            {
+                load(lane);
+                l++;
+            }
+            else
+            {
+                lane = state[--active];
+            }
+        }
+    }
+    return results;
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <variant>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <concepts>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include "cycle_detection.hpp"
+#include "index_storage.hpp"
+#include "mapped_file.hpp"
+
+// On-disk successor array: a 32-byte little-endian header followed by n
+// little-endian entries of index_width bytes each. The payload starts 8-byte
+// aligned, so a mapping of the whole file can be read in place; that needs a
+// little-endian host, as reading in place leaves no room to byte-swap.
+static_assert(std::endian::native == std::endian::little,
+              "The binary format is read in place and is little-endian");
+struct BinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t index_width;   // bytes per entry: 1, 2, 4 or 8
+    uint32_t reserved;
+    uint64_t n;
+    uint64_t checksum;      // checksum64() of the payload
+};
+static_assert(sizeof(BinaryHeader) == 32);
+
+constexpr char binary_magic[4] = {'T', 'A', 'H', 'B'};
+constexpr uint32_t binary_version = 1;
+
+// FNV-1a style mixing over 8-byte words (the last one zero-padded), which runs
+// at memory speed instead of one multiply per byte.
+inline uint64_t checksum64(const void* data, size_t bytes, uint64_t h = 0xcbf29ce484222325)
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word) * 0x100000001b3;
+    }
+    if (i < bytes)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, p + i, bytes - i);
+        h = (h ^ word) * 0x100000001b3;
+    }
+    return h;
+}
+
+inline bool is_binary_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    in.read(magic, 4);
+    return in and std::equal(magic, magic + 4, binary_magic);
+}
+
+template <std::unsigned_integral W, std::integral I>
+void write_payload(std::ofstream& out, const std::vector<I>& v, uint64_t& checksum)
+{
+    // Narrowed in blocks so no second full-size copy is ever held. The
+    // checksum is chained over 8-byte words, so blocks are a multiple of 8.
+    constexpr size_t block = 1 << 16;
+    std::vector<W> buffer;
+    for (size_t begin = 0; begin < v.size(); begin += block)
+    {
+        size_t end = std::min(v.size(), begin + block);
+        buffer.assign(v.begin() + begin, v.begin() + end);
+        size_t bytes = buffer.size()*sizeof(W);
+        checksum = checksum64(buffer.data(), bytes, checksum);
+        out.write(reinterpret_cast<const char*>(buffer.data()), bytes);
+    }
+}
+
+// Writes v using the narrowest index width that holds every index below n.
+template <std::integral I>
+void write_binary(const std::string& path, const std::vector<I>& v)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("Can't open " + path + " for writing");
+    }
+
+    BinaryHeader header{};
+    std::copy(binary_magic, binary_magic + 4, header.magic);
+    header.version = binary_version;
+    unsigned bits = PackedIndexArray::bits_for(v.size());
+    header.index_width = bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : 8;
+    header.n = v.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t checksum = 0xcbf29ce484222325;
+    switch (header.index_width)
+    {
+        case 1: write_payload<uint8_t>(out, v, checksum); break;
+        case 2: write_payload<uint16_t>(out, v, checksum); break;
+        case 4: write_payload<uint32_t>(out, v, checksum); break;
+        default: write_payload<uint64_t>(out, v, checksum); break;
+    }
+
+    header.checksum = checksum;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out)
+    {
+        throw std::runtime_error("Failed writing " + path);
+    }
+}
+
+using IndexView = std::variant<std::span<const uint8_t>,
+                               std::span<const uint16_t>,
+                               std::span<const uint32_t>,
+                               std::span<const uint64_t>>;
+
+// Read-only mapping of a binary successor file. Nothing is parsed or copied:
+// pages are faulted in as the chase touches them.
+class MappedArray
+{
+public:
+    // The chase jumps around, readahead would only waste bandwidth.
+    explicit MappedArray(const std::string& path):
+        file(path, MADV_RANDOM)
+    {
+        if (file.size() < sizeof(BinaryHeader))
+        {
+            throw std::runtime_error(path + " is too short for a binary header");
+        }
+        const BinaryHeader& h = header();
+        size_t width = h.index_width;
+        if (!std::equal(h.magic, h.magic + 4, binary_magic) or h.version != binary_version or
+            (width != 1 and width != 2 and width != 4 and width != 8) or
+            h.n > (file.size() - sizeof(BinaryHeader))/width or
+            file.size() - sizeof(BinaryHeader) != h.n*width)
+        {
+            throw std::runtime_error(path + " is not a valid binary successor file");
+        }
+    }
+
+    const BinaryHeader& header() const
+    {
+        return *static_cast<const BinaryHeader*>(file.data());
+    }
+    size_t size() const
+    {
+        return header().n;
+    }
+    const void* payload() const
+    {
+        return static_cast<const char*>(file.data()) + sizeof(BinaryHeader);
+    }
+
+    // A full sequential pass over the payload, so it is left to the caller.
+    bool verify_checksum() const
+    {
+        return checksum64(payload(), size()*header().index_width) == header().checksum;
+    }
+
+    IndexView view() const
+    {
+        switch (header().index_width)
+        {
+            case 1: return as<uint8_t>();
+            case 2: return as<uint16_t>();
+            case 4: return as<uint32_t>();
+            default: return as<uint64_t>();
+        }
+    }
+
+private:
+    template <class W>
+    std::span<const W> as() const
+    {
+        return {static_cast<const W*>(payload()), size()};
+    }
+
+    MappedFile file;
+};
+
+template <class Engine = Floyd>
+RhoResult<uint64_t> detect_cycle(const MappedArray& mapped, uint64_t start = 0)
+{
+    return std::visit([&](auto v)
+    {
+        using Index = typename decltype(v)::value_type;
+        return widen_result(detect_cycle<Engine>(v, static_cast<Index>(start)));
+    }, mapped.view());
+}
+
+template <class Engine = Floyd>
+uint64_t find_duplicates(const MappedArray& mapped)
+{
+    return detect_cycle<Engine>(mapped).entry;
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+
+// A chase that suspends itself after prefetching the node it is about to read.
+class ChaseTask
+{
+public:
+    struct promise_type
+    {
+        ChaseTask get_return_object()
+        {
+            return ChaseTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    ChaseTask() = default;
+    ChaseTask(ChaseTask&& other) noexcept:
+        handle(std::exchange(other.handle, {}))
+    {}
+    ChaseTask& operator=(ChaseTask&& other) noexcept
+    {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+    ~ChaseTask()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    bool done() const
+    {
+        return handle.done();
+    }
+    void resume()
+    {
+        handle.resume();
+    }
+
+private:
+    explicit ChaseTask(std::coroutine_handle<promise_type> h):
+        handle(h)
+    {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// co_await prefetch(&x) hints the line holding x into cache and hands control
+// back to the scheduler, which runs the other chases while the load is pending.
+struct prefetch
+{
+    const void* address;
+
+    bool await_ready() const noexcept
+    {
+        __builtin_prefetch(address);
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    void await_resume() const noexcept {}
+};
+
+// Floyd's loop where every load is preceded by a prefetch-and-yield.
+template <std::integral I>
+ChaseTask floyd_chase(const I* v, I& result)
+{
+    I tortoise = 0, hare = 0;
+    do
+    {
+        __builtin_prefetch(&v[tortoise]);
+        co_await prefetch(&v[hare]);
+        I half = v[hare];
+        co_await prefetch(&v[half]);
+        hare = v[half];
+        tortoise = v[tortoise];
+    } while (tortoise != hare);
+
+    I ptr1 = 0, ptr2 = hare;
+    while (ptr1 != ptr2)
+    {
+        __builtin_prefetch(&v[ptr1]);
+        co_await prefetch(&v[ptr2]);
+        ptr1 = v[ptr1];
+        ptr2 = v[ptr2];
+    }
+    result = ptr2;
+}
+
+// Round-robins up to `width` live chases over the arrays (AMAC-style) and
+// starts the next array whenever one finishes. Every array must be non-empty;
+// results[i] == find_duplicates(arrays[i]).
+template <std::integral I>
+std::vector<I> find_duplicates_interleaved(std::span<const std::vector<I>> arrays, size_t width = 32)
+{
+    std::vector<I> results(arrays.size());
+    if (arrays.empty())
+    {
+        return results;
+    }
+    width = std::max<size_t>(1, std::min(width, arrays.size()));
+
+    std::vector<ChaseTask> tasks;
+    tasks.reserve(width);
+    size_t next_array = 0;
+    for (; next_array < width; next_array++)
+    {
+        tasks.push_back(floyd_chase(arrays[next_array].data(), results[next_array]));
+    }
+
+    while (!tasks.empty())
+    {
+        for (size_t t = 0; t < tasks.size();)
+        {
+            tasks[t].resume();
+            if (!tasks[t].done())
+            {
+                t++;
+            }
+            else if (next_array < arrays.size())
+            {
+                tasks[t] = floyd_chase(arrays[next_array].data(), results[next_array]);
+                next_array++;
+                t++;
+            }
+            else
+            {
+                tasks[t] = std::move(tasks.back());
+                tasks.pop_back();
+            }
+        }
+    }
+    return results;
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include <vector>
+#include <concepts>
+#include <type_traits>
+#include <cstddef>
+#include <limits>
+#include <bit>
+#include <utility>
+#include <array>
+#include <algorithm>
+
+// Everything known about the rho that starts at a given node.
+template <std::regular T>
+struct RhoResult
+{
+    T meeting;             // node where the engine noticed the cycle
+    T entry;               // first node of the cycle, i.e. the duplicated value
+    size_t mu;             // tail length
+    size_t lambda;         // cycle length
+    T tail_predecessor;    // last node of the tail
+    T cycle_predecessor;   // last node of the cycle
+    size_t evaluations;    // successor lookups performed
+
+    // When mu == 0 the start node lies on the cycle, there is no tail and the
+    // predecessors do not form a pair of distinct indices sharing a value.
+    constexpr bool has_duplicate() const
+    {
+        return mu > 0;
+    }
+};
+
+template <std::regular T>
+struct CycleHit
+{
+    T meeting;
+    size_t lambda;
+};
+
+// Classic two-pointer loop; the tortoise and the hare cost three lookups per step.
+struct Floyd
+{
+    template <std::regular T, class Next>
+    static constexpr CycleHit<T> detect(Next&& next, T x0)
+    {
+        T tortoise = next(x0);
+        T hare = next(next(x0));
+        while (tortoise != hare)
+        {
+            tortoise = next(tortoise);
+            hare = next(next(hare));
+        }
+
+        size_t lambda = 1;
+        for (T x = next(tortoise); x != tortoise; x = next(x))
+        {
+            lambda++;
+        }
+        return {tortoise, lambda};
+    }
+};
+
+// Brent: the tortoise teleports to the hare at every power of two, so each
+// step is a single lookup and lambda falls out of the detection loop.
+struct Brent
+{
+    template <std::regular T, class Next>
+    static constexpr CycleHit<T> detect(Next&& next, T x0)
+    {
+        size_t power = 1, lambda = 1;
+        T tortoise = x0;
+        T hare = next(x0);
+        while (tortoise != hare)
+        {
+            if (power == lambda)
+            {
+                tortoise = hare;
+                power *= 2;
+                lambda = 0;
+            }
+            hare = next(hare);
+            lambda++;
+        }
+        return {hare, lambda};
+    }
+};
+
+// Gosper's loop detector (HAKMEM item 132): the value seen at step s is kept in
+// slot countr_zero(s), so O(log(mu+lambda)) values are remembered and every new
+// value is compared against all of them. A value is only ever overwritten, never
+// restored, so the first match is exactly one lap after the stored step.
+struct Gosper
+{
+    template <std::regular T, class Next>
+    static constexpr CycleHit<T> detect(Next&& next, T x0)
+    {
+        constexpr size_t slots = std::numeric_limits<size_t>::digits;
+        T table[slots];
+        size_t stamp[slots];
+        size_t used = 1;
+        table[0] = x0;
+        stamp[0] = 1;
+
+        T x = x0;
+        for (size_t step = 2;; step++)
+        {
+            x = next(x);
+            for (size_t k = 0; k < used; k++)
+            {
+                if (table[k] == x)
+                {
+                    return {x, step - stamp[k]};
+                }
+            }
+            size_t k = std::countr_zero(step);
+            table[k] = x;
+            stamp[k] = step;
+            if (k == used)
+            {
+                used++;
+            }
+        }
+    }
+};
+
+// Nivasch's stack algorithm: keeps a stack of strictly increasing values and
+// stops at the second visit of the smallest node of the cycle, i.e. within
+// mu + 2*lambda lookups, using O(log n) expected memory.
+struct Nivasch
+{
+    template <std::totally_ordered T, class Next>
+    static constexpr CycleHit<T> detect(Next&& next, T x0)
+    {
+        std::vector<std::pair<T, size_t>> stack;
+        T x = x0;
+        for (size_t step = 0;; step++)
+        {
+            while (!stack.empty() and stack.back().first > x)
+            {
+                stack.pop_back();
+            }
+            if (!stack.empty() and stack.back().first == x)
+            {
+                return {x, step - stack.back().second};
+            }
+            stack.emplace_back(x, step);
+            x = next(x);
+        }
+    }
+};
+
+// Given lambda, walks two pointers lambda apart from x0 until they meet at the
+// cycle entry, remembering where each came from.
+template <std::regular T, class Next>
+constexpr RhoResult<T> locate_entry(Next&& next, T x0, CycleHit<T> hit)
+{
+    T hare = x0;
+    for (size_t i = 0; i < hit.lambda; i++)
+    {
+        hare = next(hare);
+    }
+
+    T tortoise = x0;
+    T tortoise_prev = x0, hare_prev = x0;
+    size_t mu = 0;
+    while (tortoise != hare)
+    {
+        tortoise_prev = tortoise;
+        hare_prev = hare;
+        tortoise = next(tortoise);
+        hare = next(hare);
+        mu++;
+    }
+    return {hit.meeting, tortoise, mu, hit.lambda, tortoise_prev, hare_prev, 0};
+}
+
+// Keeps the last Window nodes of the chain in a ring buffer and compares every
+// new node against them. A single chase cannot usefully prefetch, because the
+// next address is the value being loaded, so instead this engine drops loads:
+// a cycle of length <= Window is caught at its first repetition, after exactly
+// mu + lambda lookups, and the ring already holds the entry and both of its
+// predecessors, so no second pass is needed. Longer cycles are caught by a
+// Brent tortoise riding along and resolved with locate_entry().
+template <size_t Window = 16>
+struct Trail
+{
+    template <std::regular T, class Next>
+    static constexpr RhoResult<T> run(Next&& next, T x0)
+    {
+        std::array<T, Window> ring;
+        T evicted = x0;   // node that just left the ring
+        size_t power = 1, lambda = 0;
+        T tortoise = x0;
+
+        T x = x0;
+        for (size_t step = 0;; step++)
+        {
+            size_t kept = std::min(step, Window);
+            for (size_t back = 1; back <= kept; back++)
+            {
+                size_t seen = step - back;
+                if (ring[seen % Window] == x)
+                {
+                    T tail_predecessor = seen == 0 ? x :
+                                         back == Window ? evicted : ring[(seen - 1) % Window];
+                    T cycle_predecessor = ring[(step - 1) % Window];
+                    return {x, x, seen, back, tail_predecessor, cycle_predecessor, 0};
+                }
+            }
+            if (step > 0 and tortoise == x)
+            {
+                return locate_entry(next, x0, CycleHit<T>{x, lambda});
+            }
+            if (step > 0 and power == lambda)
+            {
+                tortoise = x;
+                power *= 2;
+                lambda = 0;
+            }
+
+            if (step >= Window)
+            {
+                evicted = ring[step % Window];
+            }
+            ring[step % Window] = x;
+            x = next(x);
+            lambda++;
+        }
+    }
+};
+
+// A successor function over states of type T: PRNG transitions, hash
+// iteration, x -> f(x) mod m, or a lookup into a successor array.
+template <class F, class T>
+concept SuccessorFunction = std::regular<T> and std::regular_invocable<F&, const T&> and
+                            std::convertible_to<std::invoke_result_t<F&, const T&>, T>;
+
+// Finds the rho of f starting at x0. Everything is inlined into the engine's
+// loop, so for a plain callable this is the hand-written loop plus a step
+// counter, and it can run at compile time for constexpr callables.
+template <class Engine = Floyd, std::regular T, SuccessorFunction<T> F>
+constexpr RhoResult<T> find_cycle(F f, T x0)
+{
+    size_t evaluations = 0;
+    auto next = [&](const T& x) -> T
+    {
+        evaluations++;
+        return f(x);
+    };
+
+    RhoResult<T> result;
+    if constexpr (requires { Engine::run(next, x0); })
+    {
+        result = Engine::run(next, x0);
+    }
+    else
+    {
+        result = locate_entry(next, x0, Engine::detect(next, x0));
+    }
+    result.evaluations = evaluations;
+    return result;
+}
+
+// Anything indexable by node that yields the successor node: std::vector,
+// std::span, PackedIndexArray...
+template <class A>
+concept IndexArray = std::integral<typename A::value_type> and requires(const A& a, size_t i)
+{
+    { a[i] } -> std::convertible_to<typename A::value_type>;
+    { a.size() } -> std::convertible_to<size_t>;
+};
+
+// The array case: the successor of node x is v[x].
+template <class Engine = Floyd, IndexArray A>
+RhoResult<typename A::value_type> detect_cycle(const A& v, typename A::value_type start = 0)
+{
+    using I = typename A::value_type;
+    return find_cycle<Engine>([&v](I x){ return static_cast<I>(v[x]); }, start);
+}
+
+// Returns the value reached twice on the rho starting at index 0.
+template <class Engine = Floyd, IndexArray A>
+auto find_duplicates(const A& v)
+{
+    return detect_cycle<Engine>(v).entry;
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <stdexcept>
+#include <concepts>
+#include <cstdint>
+#include <cstddef>
+#include "cycle_detection.hpp"
+#include "random.hpp"
+
+// Two distinct states with the same image under f.
+template <std::unsigned_integral T>
+struct Collision
+{
+    T first, second;
+    T value;              // f(first) == f(second) == value
+    size_t evaluations;   // f calls across all threads
+};
+
+struct DistinguishedPointOptions
+{
+    unsigned dp_bits = 8;   // a state is distinguished when its low dp_bits are zero
+    size_t threads = std::thread::hardware_concurrency();
+    uint64_t seed = std::random_device{}();
+    // Trails longer than this many times the expected 2^dp_bits are assumed to
+    // be stuck in a cycle without distinguished points and are dropped.
+    size_t max_trail_factor = 20;
+    // A permutation has no collision at all, so the search needs a budget.
+    size_t max_evaluations = std::numeric_limits<size_t>::max();
+};
+
+// van Oorschot-Wiener parallel collision search for a function on [0, domain).
+// Every thread walks from random starts until it hits a distinguished point and
+// records (start, length) for it in a sharded table. Two trails reaching the
+// same distinguished point from different starts merged somewhere: re-walking
+// both, aligned by length, finds the two distinct preimages of the merge point.
+// Threads only share the table, so the speedup is close to linear.
+template <std::unsigned_integral T, SuccessorFunction<T> F>
+std::optional<Collision<T>> find_collision_parallel(F f, T domain, DistinguishedPointOptions options = {})
+{
+    if (domain == 0)
+    {
+        throw std::invalid_argument("Collision search needs a non-empty domain");
+    }
+    // The trail limit max_trail_factor*2^dp_bits has to fit a size_t.
+    if (options.dp_bits >= std::numeric_limits<size_t>::digits or
+        options.max_trail_factor > (std::numeric_limits<size_t>::max() >> options.dp_bits))
+    {
+        throw std::invalid_argument("A trail limit of " + std::to_string(options.max_trail_factor) + " * 2^" +
+                                    std::to_string(options.dp_bits) + " steps does not fit a size_t");
+    }
+    struct Trail
+    {
+        T start;
+        size_t length;
+    };
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<T, Trail> points;
+    };
+    constexpr size_t n_shards = 64;
+    std::vector<Shard> shards(n_shards);
+
+    const T mask = options.dp_bits >= std::numeric_limits<T>::digits ? ~T(0) : (T(1) << options.dp_bits) - 1;
+    const size_t max_length = options.max_trail_factor << options.dp_bits;
+
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> evaluations = 0;
+    std::mutex result_mutex;
+    std::optional<Collision<T>> result;
+
+    // Walks both trails to their merge point; nullopt if one start lies on the
+    // other trail (a "Robin Hood"), which gives no collision.
+    auto resolve = [&](Trail a, Trail b, size_t& calls) -> std::optional<Collision<T>>
+    {
+        if (a.length < b.length)
+        {
+            std::swap(a, b);
+        }
+        T x = a.start, y = b.start;
+        for (size_t i = b.length; i < a.length; i++)
+        {
+            x = f(x);
+            calls++;
+        }
+        if (x == y)
+        {
+            return std::nullopt;
+        }
+        while (true)
+        {
+            T fx = f(x), fy = f(y);
+            calls += 2;
+            if (fx == fy)
+            {
+                return Collision<T>{x, y, fx, 0};
+            }
+            x = fx;
+            y = fy;
+        }
+    };
+
+    // Thread t draws its starts from the t-th jump-ahead stream of the seed,
+    // so a fixed options.seed reproduces the starts of every thread.
+    auto walk = [&](size_t t)
+    {
+        RandomGen<T> random_start(0, domain - 1, options.seed);
+        for (size_t j = 0; j < t; j++)
+        {
+            random_start.jump();
+        }
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            T start = random_start();
+            T x = start;
+            size_t length = 0;
+            while ((x & mask) != 0 and length <= max_length)
+            {
+                x = f(x);
+                length++;
+            }
+            if (evaluations.fetch_add(length, std::memory_order_relaxed) + length >= options.max_evaluations)
+            {
+                stop = true;
+            }
+            if (length > max_length)
+            {
+                continue;
+            }
+
+            // The low dp_bits of a distinguished point are all zero.
+            Shard& shard = shards[(x >> std::min<unsigned>(options.dp_bits, std::numeric_limits<T>::digits - 1)) % n_shards];
+            std::optional<Trail> other;
+            {
+                std::lock_guard lock(shard.mutex);
+                auto [it, inserted] = shard.points.try_emplace(x, Trail{start, length});
+                if (!inserted)
+                {
+                    other = it->second;
+                }
+            }
+            if (!other)
+            {
+                continue;
+            }
+
+            size_t calls = 0;
+            auto collision = resolve(*other, Trail{start, length}, calls);
+            evaluations.fetch_add(calls, std::memory_order_relaxed);
+            if (collision)
+            {
+                std::lock_guard lock(result_mutex);
+                if (!result)
+                {
+                    result = collision;
+                }
+                stop = true;
+            }
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    for (size_t t = 0; t < std::max<size_t>(1, options.threads); t++)
+    {
+        threads.emplace_back(walk, t);
+    }
+    threads.clear();   // joins
+
+    if (result)
+    {
+        result->evaluations = evaluations;
+    }
+    return result;
+}
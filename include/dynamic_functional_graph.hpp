@@ -0,0 +1,276 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <concepts>
+#include <stdexcept>
+#include <type_traits>
+#include <limits>
+#include <cstddef>
+
+// Functional graph under point updates v[i] = t, with the rho queries of
+// RhoIndex in O(log n) amortized instead of O(1) after an O(n) rebuild.
+//
+// Every component is a tree plus one extra edge. The trees live in a link-cut
+// tree, and the component's tree root r keeps its own edge r -> s aside as
+// the "special" edge. The cycle is then the tree path from s up to r, so:
+//   entry(x)        = lca(x, s)
+//   tail_length(x)  = depth(x) - depth(entry(x))
+//   cycle_length(x) = depth(s) + 1
+// In-degrees are kept alongside, so duplicate counts stay exact at O(1) per
+// update.
+template <std::integral I>
+class DynamicFunctionalGraph
+{
+public:
+    explicit DynamicFunctionalGraph(const std::vector<I>& v):
+        n(v.size()),
+        nil(sentinel(v.size())),
+        next(v),
+        special(v.size(), nil),
+        in_degree(v.size()),
+        nodes(v.size() + 1, Node{{nil, nil}, nil, 1})
+    {
+        nodes[nil].size = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            check(static_cast<I>(i), v[i]);
+            count_in(v[i], +1);
+            attach(static_cast<I>(i), v[i]);
+        }
+    }
+
+    size_t size() const
+    {
+        return n;
+    }
+    I successor(I x) const
+    {
+        return next[x];
+    }
+
+    void set(I i, I t)
+    {
+        check(i, t);
+        count_in(next[i], -1);
+        detach(i);
+        next[i] = t;
+        count_in(t, +1);
+        attach(i, t);
+    }
+
+    // Root of x's tree; identifies the component until the next update.
+    I component(I x)
+    {
+        return find_root(x);
+    }
+    I entry(I x)
+    {
+        return lca(x, special[find_root(x)]);
+    }
+    size_t tail_length(I x)
+    {
+        I e = entry(x);
+        return depth(x) - depth(e);
+    }
+    size_t cycle_length(I x)
+    {
+        return depth(special[find_root(x)]) + 1;
+    }
+    bool on_cycle(I x)
+    {
+        return entry(x) == x;
+    }
+
+    // The find_duplicates() answer: where the rho from 0 enters its cycle.
+    I find_duplicate()
+    {
+        return entry(0);
+    }
+    size_t multiplicity(I x) const
+    {
+        return in_degree[x];
+    }
+    // Number of distinct values with more than one preimage.
+    size_t duplicate_count() const
+    {
+        return duplicated_values;
+    }
+
+private:
+    // Node n is the sentinel, so the index type must also hold n. An empty
+    // graph is rejected too: it has no node 0 for find_duplicate().
+    static I sentinel(size_t n)
+    {
+        if (n == 0)
+        {
+            throw std::invalid_argument("A dynamic graph needs at least one node");
+        }
+        if (n > static_cast<size_t>(std::numeric_limits<I>::max()))
+        {
+            throw std::invalid_argument("A dynamic graph of " + std::to_string(n) + " nodes needs an index type "
+                                        "that holds " + std::to_string(n));
+        }
+        return static_cast<I>(n);
+    }
+
+    struct Node
+    {
+        I child[2];
+        I parent;   // splay parent, or path parent when x is a splay root
+        I size;     // nodes in x's splay subtree
+    };
+
+    void check(I i, I t) const
+    {
+        using U = std::make_unsigned_t<I>;
+        if (static_cast<U>(i) >= n or static_cast<U>(t) >= n)
+        {
+            throw std::out_of_range("Edge " + std::to_string(i) + " -> " + std::to_string(t) +
+                                    " is outside [0, " + std::to_string(n) + ")");
+        }
+    }
+
+    void count_in(I x, int delta)
+    {
+        duplicated_values -= in_degree[x] > 1;
+        in_degree[x] += delta;
+        duplicated_values += in_degree[x] > 1;
+    }
+
+    // Removes i's outgoing edge, leaving i the root of a tree with no special
+    // edge. Cutting a cycle edge turns the old special edge into a tree edge.
+    void detach(I i)
+    {
+        if (special[i] != nil)
+        {
+            special[i] = nil;
+            return;
+        }
+        I r = find_root(i);
+        I s = special[r];
+        bool cycle_edge = lca(i, s) == i;
+        cut(i);
+        if (cycle_edge)
+        {
+            special[r] = nil;
+            link(r, s);
+        }
+    }
+
+    // Gives the edgeless tree root i the edge i -> t.
+    void attach(I i, I t)
+    {
+        if (find_root(t) == i)
+        {
+            special[i] = t;
+        }
+        else
+        {
+            link(i, t);
+        }
+    }
+
+    // Link-cut tree over the tree edges, without reversal: links always hang
+    // a tree root below another node, so the represented roots never change
+    // except through cut and link themselves.
+    bool is_splay_root(I x) const
+    {
+        I p = nodes[x].parent;
+        return p == nil or (nodes[p].child[0] != x and nodes[p].child[1] != x);
+    }
+    void update(I x)
+    {
+        nodes[x].size = 1 + nodes[nodes[x].child[0]].size + nodes[nodes[x].child[1]].size;
+    }
+    void rotate(I x)
+    {
+        I p = nodes[x].parent, g = nodes[p].parent;
+        int side = nodes[p].child[1] == x;
+        if (!is_splay_root(p))
+        {
+            nodes[g].child[nodes[g].child[1] == p] = x;
+        }
+        nodes[x].parent = g;
+        I moved = nodes[x].child[!side];
+        nodes[p].child[side] = moved;
+        if (moved != nil)
+        {
+            nodes[moved].parent = p;
+        }
+        nodes[x].child[!side] = p;
+        nodes[p].parent = x;
+        update(p);
+        update(x);
+    }
+    void splay(I x)
+    {
+        while (!is_splay_root(x))
+        {
+            I p = nodes[x].parent;
+            if (!is_splay_root(p))
+            {
+                I g = nodes[p].parent;
+                bool zigzig = (nodes[g].child[1] == p) == (nodes[p].child[1] == x);
+                rotate(zigzig ? p : x);
+            }
+            rotate(x);
+        }
+    }
+    // Makes root..x the preferred path, with x at the splay root. Returns the
+    // last path-parent crossed, which after access(u) is lca(u, x).
+    I access(I x)
+    {
+        I last = nil;
+        for (I y = x; y != nil; y = nodes[y].parent)
+        {
+            splay(y);
+            nodes[y].child[1] = last;
+            update(y);
+            last = y;
+        }
+        splay(x);
+        return last;
+    }
+
+    I find_root(I x)
+    {
+        access(x);
+        while (nodes[x].child[0] != nil)
+        {
+            x = nodes[x].child[0];
+        }
+        splay(x);
+        return x;
+    }
+    size_t depth(I x)
+    {
+        access(x);
+        return nodes[nodes[x].child[0]].size;
+    }
+    I lca(I x, I y)
+    {
+        access(x);
+        return access(y);
+    }
+    void cut(I x)
+    {
+        access(x);
+        I above = nodes[x].child[0];
+        nodes[above].parent = nil;
+        nodes[x].child[0] = nil;
+        update(x);
+    }
+    void link(I root, I p)
+    {
+        access(root);
+        nodes[root].parent = p;
+    }
+
+    size_t n;
+    I nil;                        // sentinel node with size 0
+    std::vector<I> next;
+    std::vector<I> special;       // special[r]: edge of tree root r, nil elsewhere
+    std::vector<size_t> in_degree;
+    size_t duplicated_values = 0;
+    std::vector<Node> nodes;
+};
@@ -0,0 +1,587 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <queue>
+#include <memory>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <bit>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "binary_format.hpp"
+#include "validation.hpp"
+
+// Bytes moved by the out-of-core algorithms, all of it in sequential blocks.
+struct IoStats
+{
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+};
+
+// Scratch space and memory budget shared by the external passes. Every
+// temporary file is removed when its ScratchFile goes away.
+class ExternalWorkspace
+{
+public:
+    ExternalWorkspace(size_t memory_bytes, std::filesystem::path directory = std::filesystem::temp_directory_path()):
+        memory(std::max<size_t>(memory_bytes, size_t(1) << 20)),
+        directory(std::move(directory)),
+        prefix("tah_external_" + std::to_string(::getpid()) + "_")
+    {}
+
+    size_t memory_bytes() const
+    {
+        return memory;
+    }
+    // Buffer per open stream: large enough that every transfer is sequential,
+    // small enough that a merge can keep many runs open.
+    size_t block_bytes() const
+    {
+        return std::clamp<size_t>(memory/32, size_t(64) << 10, size_t(4) << 20);
+    }
+    std::string new_path()
+    {
+        return (directory/(prefix + std::to_string(next_id++))).string();
+    }
+
+    IoStats io;
+
+private:
+    size_t memory;
+    std::filesystem::path directory;
+    std::string prefix;
+    size_t next_id = 0;
+};
+
+class ScratchFile
+{
+public:
+    explicit ScratchFile(ExternalWorkspace& workspace):
+        file_path(workspace.new_path())
+    {}
+    ScratchFile(ScratchFile&& other) noexcept:
+        file_path(std::exchange(other.file_path, {}))
+    {}
+    ScratchFile& operator=(ScratchFile&& other) noexcept
+    {
+        std::swap(file_path, other.file_path);
+        return *this;
+    }
+    ~ScratchFile()
+    {
+        if (!file_path.empty())
+        {
+            ::unlink(file_path.c_str());
+        }
+    }
+
+    const std::string& path() const
+    {
+        return file_path;
+    }
+
+private:
+    std::string file_path;
+};
+
+// Buffered sequential reader of fixed-size records, starting at `offset`.
+template <class T>
+class RecordReader
+{
+public:
+    RecordReader(const std::string& path, ExternalWorkspace& workspace, size_t offset = 0):
+        io(workspace.io),
+        buffer(std::max<size_t>(1, workspace.block_bytes()/sizeof(T)))
+    {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0 or ::lseek(fd, offset, SEEK_SET) < 0)
+        {
+            throw std::runtime_error("Can't read " + path + ": " + std::strerror(errno));
+        }
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+    ~RecordReader()
+    {
+        ::close(fd);
+    }
+
+    bool next(T& record)
+    {
+        if (position == filled and !refill())
+        {
+            return false;
+        }
+        record = buffer[position++];
+        return true;
+    }
+
+private:
+    bool refill()
+    {
+        size_t bytes = 0;
+        char* data = reinterpret_cast<char*>(buffer.data());
+        while (bytes < buffer.size()*sizeof(T))
+        {
+            ssize_t got = ::read(fd, data + bytes, buffer.size()*sizeof(T) - bytes);
+            if (got < 0 and errno == EINTR)
+            {
+                continue;
+            }
+            if (got < 0)
+            {
+                throw std::runtime_error(std::string("Read failed: ") + std::strerror(errno));
+            }
+            if (got == 0)
+            {
+                break;
+            }
+            bytes += got;
+        }
+        io.bytes_read += bytes;
+        position = 0;
+        filled = bytes/sizeof(T);
+        return filled > 0;
+    }
+
+    IoStats& io;
+    int fd = -1;
+    std::vector<T> buffer;
+    size_t position = 0, filled = 0;
+};
+
+template <class T>
+class RecordWriter
+{
+public:
+    RecordWriter(const std::string& path, ExternalWorkspace& workspace):
+        io(workspace.io)
+    {
+        buffer.reserve(std::max<size_t>(1, workspace.block_bytes()/sizeof(T)));
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't write " + path + ": " + std::strerror(errno));
+        }
+    }
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+    ~RecordWriter()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    void write(const T& record)
+    {
+        buffer.push_back(record);
+        if (buffer.size() == buffer.capacity())
+        {
+            flush();
+        }
+    }
+    void write(const T* records, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            write(records[i]);
+        }
+    }
+
+    // Throws on a failed write; the destructor would have to swallow it.
+    void close()
+    {
+        flush();
+        if (::close(std::exchange(fd, -1)) != 0)
+        {
+            throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+        }
+    }
+
+private:
+    void flush()
+    {
+        const char* data = reinterpret_cast<const char*>(buffer.data());
+        size_t bytes = buffer.size()*sizeof(T), done = 0;
+        while (done < bytes)
+        {
+            ssize_t put = ::write(fd, data + done, bytes - done);
+            if (put < 0 and errno == EINTR)
+            {
+                continue;
+            }
+            if (put <= 0)
+            {
+                throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+            }
+            done += put;
+        }
+        io.bytes_written += bytes;
+        buffer.clear();
+    }
+
+    IoStats& io;
+    int fd = -1;
+    std::vector<T> buffer;
+};
+
+// Multiway merge sort of a record file by key(record): sorted runs of one
+// memory budget each, then merges of as many runs as the budget holds
+// blocks for, repeated until one run is left.
+template <class T, class Key>
+ScratchFile external_sort(const std::string& input, Key key, ExternalWorkspace& workspace)
+{
+    auto less = [&](const T& a, const T& b){ return key(a) < key(b); };
+    std::vector<ScratchFile> runs;
+    {
+        // The budget less the reader and writer blocks open next to it.
+        std::vector<T> chunk;
+        chunk.reserve(std::max<size_t>(1, (workspace.memory_bytes() - 2*workspace.block_bytes())/sizeof(T)));
+        RecordReader<T> in(input, workspace);
+        T record;
+        bool more = true;
+        while (more)
+        {
+            chunk.clear();
+            while (chunk.size() < chunk.capacity() and (more = in.next(record)))
+            {
+                chunk.push_back(record);
+            }
+            if (chunk.empty() and !runs.empty())
+            {
+                break;
+            }
+            std::sort(chunk.begin(), chunk.end(), less);
+            runs.emplace_back(workspace);
+            RecordWriter<T> out(runs.back().path(), workspace);
+            out.write(chunk.data(), chunk.size());
+            out.close();
+        }
+    }
+
+    const size_t fan_in = std::max<size_t>(2, workspace.memory_bytes()/workspace.block_bytes() - 1);
+    while (runs.size() > 1)
+    {
+        std::vector<ScratchFile> merged;
+        for (size_t first = 0; first < runs.size(); first += fan_in)
+        {
+            size_t last = std::min(runs.size(), first + fan_in);
+            merged.emplace_back(workspace);
+            if (last - first == 1)
+            {
+                std::swap(merged.back(), runs[first]);
+                continue;
+            }
+            std::vector<std::unique_ptr<RecordReader<T>>> readers;
+            using Head = std::pair<T, size_t>;
+            auto later = [&](const Head& a, const Head& b){ return less(b.first, a.first); };
+            std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+            for (size_t r = first; r < last; r++)
+            {
+                readers.push_back(std::make_unique<RecordReader<T>>(runs[r].path(), workspace));
+                T record;
+                if (readers.back()->next(record))
+                {
+                    heads.emplace(record, readers.size() - 1);
+                }
+            }
+            RecordWriter<T> out(merged.back().path(), workspace);
+            while (!heads.empty())
+            {
+                auto [record, r] = heads.top();
+                heads.pop();
+                out.write(record);
+                if (readers[r]->next(record))
+                {
+                    heads.emplace(record, r);
+                }
+            }
+            out.close();
+        }
+        runs = std::move(merged);
+    }
+    return std::move(runs.front());
+}
+
+// What the out-of-core pass knows about node x after 2^k steps: the node
+// reached, and a summary of the window x, f(x), ..., f^(2^k - 1)(x).
+struct ExternalLink
+{
+    uint64_t node;
+    uint64_t next;
+    uint64_t value;
+    uint64_t first;
+};
+
+// Pointer doubling by sort and merge. `links` holds one record per node in
+// node order; every level sorts a copy by `next`, streams it against the
+// node-ordered file to look up the record of next, and sorts the joined
+// records back into node order:
+//   next' = next(next), combine(a, b) merges the summary of the following
+//   window b into a.
+// Stops early once settled() holds for every record, i.e. no further level
+// could change one.
+template <class Combine, class Settled>
+ScratchFile double_links(ScratchFile links, unsigned levels, Combine combine, Settled settled,
+                         ExternalWorkspace& workspace)
+{
+    bool all_settled = false;
+    for (unsigned k = 0; k < levels and !all_settled; k++)
+    {
+        ScratchFile by_next = external_sort<ExternalLink>(links.path(),
+                                                          [](const ExternalLink& l){ return l.next; }, workspace);
+        ScratchFile joined(workspace);
+        {
+            RecordReader<ExternalLink> queries(by_next.path(), workspace);
+            RecordReader<ExternalLink> table(links.path(), workspace);
+            RecordWriter<ExternalLink> out(joined.path(), workspace);
+            ExternalLink q, t{};
+            bool have = table.next(t);
+            all_settled = true;
+            while (queries.next(q))
+            {
+                while (have and t.node < q.next)
+                {
+                    have = table.next(t);
+                }
+                q.next = t.next;
+                combine(q, t);
+                all_settled = all_settled and settled(q);
+                out.write(q);
+            }
+            out.close();
+        }
+        links = external_sort<ExternalLink>(joined.path(), [](const ExternalLink& l){ return l.node; }, workspace);
+    }
+    return links;
+}
+
+// A value that occurs `count` > 1 times in the successor file.
+struct ExternalDuplicate
+{
+    uint64_t value;
+    uint64_t count;
+};
+
+struct ExternalRhoResult
+{
+    uint64_t entry;          // first cycle node from 0, the find_duplicates() answer
+    uint64_t mu;             // tail length from 0
+    uint64_t lambda;         // cycle length from 0
+    uint64_t cycles;         // cycles in the whole graph
+    uint64_t cycle_nodes;    // nodes on any cycle
+    uint64_t max_tail;       // longest tail of any node
+    uint64_t duplicate_values;   // values that occur more than once
+    uint64_t duplicate_entries;  // entries repeating a value seen before
+    IoStats io;
+};
+
+// Rho of node 0, the cycle structure and the duplicates of a binary successor
+// file (see binary_format.hpp) too large to chase in memory, with sequential
+// I/O only. The duplicates come from one external sort of the input by
+// successor, counting runs of equal successors; with a `duplicates_path` they
+// are also written there as ExternalDuplicate records, by value. Then two
+// doubling passes of ceil(log2 n) levels, each level two external sorts of n
+// 32-byte records:
+//  1. value = the smallest node in the window. After 2^K >= n steps every
+//     node has reached its cycle, so the cycle nodes are the image of next,
+//     and on a cycle the window minimum identifies the cycle.
+//  2. value = non-cycle nodes in the window, first = first cycle node in it.
+//     After 2^K steps these are the tail length and the cycle entry; this
+//     pass ends as soon as every window has reached its cycle.
+inline ExternalRhoResult external_rho(const std::string& path, ExternalWorkspace& workspace,
+                                      const std::string& duplicates_path = {})
+{
+    constexpr uint64_t none = UINT64_MAX;
+    BinaryHeader header{};
+    {
+        RecordReader<BinaryHeader> in(path, workspace);
+        size_t width = 0;
+        if (in.next(header))
+        {
+            width = header.index_width;
+        }
+        if (!std::equal(header.magic, header.magic + 4, binary_magic) or header.version != binary_version or
+            (width != 1 and width != 2 and width != 4 and width != 8))
+        {
+            throw std::runtime_error(path + " is not a valid binary successor file");
+        }
+    }
+    const uint64_t n = header.n;
+    if (n == 0)
+    {
+        throw std::invalid_argument(path + " holds no nodes");
+    }
+    const unsigned levels = std::bit_width(n - 1);
+
+    // Streams f as (x, f(x)) to emit(x, f(x)), checking every entry.
+    auto scan_input = [&](auto emit)
+    {
+        auto scan = [&]<class W>(W)
+        {
+            RecordReader<W> in(path, workspace, sizeof(BinaryHeader));
+            W target;
+            for (uint64_t x = 0; x < n; x++)
+            {
+                if (!in.next(target))
+                {
+                    throw std::runtime_error(path + " is shorter than its header says");
+                }
+                if (target >= n)
+                {
+                    throw ValidationError("Entry " + std::to_string(x) + " = " + std::to_string(target) +
+                                          " is outside [0, " + std::to_string(n) + ")", x);
+                }
+                emit(x, static_cast<uint64_t>(target));
+            }
+        };
+        switch (header.index_width)
+        {
+            case 1: scan(uint8_t()); break;
+            case 2: scan(uint16_t()); break;
+            case 4: scan(uint32_t()); break;
+            default: scan(uint64_t()); break;
+        }
+    };
+
+    ScratchFile links(workspace);
+    {
+        RecordWriter<ExternalLink> out(links.path(), workspace);
+        scan_input([&](uint64_t x, uint64_t target){ out.write({x, target, x, none}); });
+        out.close();
+    }
+
+    ExternalRhoResult result{};
+    {
+        ScratchFile by_target = external_sort<ExternalLink>(links.path(),
+                                                            [](const ExternalLink& l){ return l.next; }, workspace);
+        RecordReader<ExternalLink> in(by_target.path(), workspace);
+        std::unique_ptr<RecordWriter<ExternalDuplicate>> out;
+        if (!duplicates_path.empty())
+        {
+            out = std::make_unique<RecordWriter<ExternalDuplicate>>(duplicates_path, workspace);
+        }
+        ExternalDuplicate run{none, 0};
+        auto end_run = [&]
+        {
+            if (run.count > 1)
+            {
+                result.duplicate_values++;
+                result.duplicate_entries += run.count - 1;
+                if (out)
+                {
+                    out->write(run);
+                }
+            }
+        };
+        ExternalLink l;
+        while (in.next(l))
+        {
+            if (l.next != run.value)
+            {
+                end_run();
+                run = {l.next, 0};
+            }
+            run.count++;
+        }
+        end_run();
+        if (out)
+        {
+            out->close();
+        }
+    }
+
+    links = double_links(std::move(links), levels, [](ExternalLink& a, const ExternalLink& b)
+    {
+        a.value = std::min(a.value, b.value);
+    }, [](const ExternalLink&){ return false; }, workspace);
+
+    // Cycle ids of the cycle nodes, in node order.
+    ScratchFile cycle_ids(workspace);
+    {
+        ScratchFile image = external_sort<ExternalLink>(links.path(),
+                                                        [](const ExternalLink& l){ return l.next; }, workspace);
+        RecordReader<ExternalLink> reached(image.path(), workspace);
+        RecordReader<ExternalLink> nodes(links.path(), workspace);
+        RecordWriter<ExternalLink> out(cycle_ids.path(), workspace);
+        ExternalLink r{}, x;
+        bool have = reached.next(r);
+        while (nodes.next(x))
+        {
+            while (have and r.next < x.node)
+            {
+                have = reached.next(r);
+            }
+            if (have and r.next == x.node)
+            {
+                out.write(x);
+                result.cycle_nodes++;
+                result.cycles += x.value == x.node;
+            }
+        }
+        out.close();
+    }
+
+    {
+        RecordReader<ExternalLink> on_cycle(cycle_ids.path(), workspace);
+        RecordWriter<ExternalLink> out(links.path(), workspace);
+        ExternalLink c{};
+        bool have = on_cycle.next(c);
+        scan_input([&](uint64_t x, uint64_t target)
+        {
+            bool cyclic = have and c.node == x;
+            out.write({x, target, !cyclic, cyclic ? x : none});
+            if (cyclic)
+            {
+                have = on_cycle.next(c);
+            }
+        });
+        out.close();
+    }
+    links = double_links(std::move(links), levels, [](ExternalLink& a, const ExternalLink& b)
+    {
+        a.value += b.value;
+        a.first = a.first != none ? a.first : b.first;
+    }, [](const ExternalLink& l){ return l.first != none; }, workspace);
+
+    {
+        RecordReader<ExternalLink> in(links.path(), workspace);
+        ExternalLink l;
+        while (in.next(l))
+        {
+            if (l.node == 0)
+            {
+                result.mu = l.value;
+                result.entry = l.first;
+            }
+            result.max_tail = std::max(result.max_tail, l.value);
+        }
+    }
+    uint64_t entry_cycle = none;
+    for (int scan = 0; scan < 2; scan++)
+    {
+        RecordReader<ExternalLink> in(cycle_ids.path(), workspace);
+        ExternalLink c;
+        while (in.next(c))
+        {
+            if (scan == 0 and c.node == result.entry)
+            {
+                entry_cycle = c.value;
+                break;
+            }
+            result.lambda += scan == 1 and c.value == entry_cycle;
+        }
+    }
+    result.io = workspace.io;
+    return result;
+}
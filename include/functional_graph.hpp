@@ -0,0 +1,118 @@
+#pragma once
+#include <vector>
+#include <concepts>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+template <std::integral I>
+struct CycleInfo
+{
+    I representative;   // smallest node on the cycle
+    size_t length;
+};
+
+// Decomposition of x -> v[x] into its weakly connected components. Every
+// component of a functional graph holds exactly one cycle, so the component
+// id of a node is also the id of the cycle it ends up in.
+template <std::integral I>
+struct FunctionalGraph
+{
+    std::vector<I> component;   // numbered in order of each component's smallest node
+    std::vector<I> distance;    // steps until the cycle is reached
+    std::vector<I> entry;       // first cycle node reached
+    std::vector<CycleInfo<I>> cycles;
+    std::vector<std::pair<I, size_t>> duplicates;   // value and multiplicity, by value
+
+    bool on_cycle(I x) const
+    {
+        return distance[x] == 0;
+    }
+    const CycleInfo<I>& cycle_of(I x) const
+    {
+        return cycles[component[x]];
+    }
+};
+
+template <std::integral I>
+std::vector<std::pair<I, size_t>> count_duplicates(const std::vector<I>& v)
+{
+    // At least 32 bits: n entries of a narrow type can all point at one value.
+    std::vector<std::common_type_t<std::make_unsigned_t<I>, uint32_t>> in_degree(v.size());
+    for (I x: v)
+    {
+        in_degree[x]++;
+    }
+
+    std::vector<std::pair<I, size_t>> duplicates;
+    for (size_t x = 0; x < in_degree.size(); x++)
+    {
+        if (in_degree[x] > 1)
+        {
+            duplicates.emplace_back(static_cast<I>(x), in_degree[x]);
+        }
+    }
+    return duplicates;
+}
+
+// Labels every node in O(n): each node is pushed onto the walk path once and
+// labelled once while the path unwinds.
+template <std::integral I>
+FunctionalGraph<I> analyze_functional_graph(const std::vector<I>& v)
+{
+    const size_t n = v.size();
+    FunctionalGraph<I> g;
+    g.component.resize(n);
+    g.distance.resize(n);
+    g.entry.resize(n);
+
+    std::vector<bool> visited(n);
+    std::vector<I> path;
+    for (size_t start = 0; start < n; start++)
+    {
+        if (visited[start])
+        {
+            continue;
+        }
+
+        I x = static_cast<I>(start);
+        while (!visited[x])
+        {
+            visited[x] = true;
+            path.push_back(x);
+            x = v[x];
+        }
+
+        // Stopping on a node of the current walk closes a new cycle; otherwise
+        // the walk ran into a component labelled earlier.
+        auto tail_end = path.end();
+        auto hit = std::find(path.rbegin(), path.rend(), x);
+        if (hit != path.rend())
+        {
+            tail_end = std::prev(hit.base());
+            I id = static_cast<I>(g.cycles.size());
+            I representative = *std::min_element(tail_end, path.end());
+            for (auto it = tail_end; it != path.end(); ++it)
+            {
+                g.component[*it] = id;
+                g.distance[*it] = 0;
+                g.entry[*it] = *it;
+            }
+            g.cycles.push_back({representative, static_cast<size_t>(path.end() - tail_end)});
+        }
+
+        for (auto it = std::make_reverse_iterator(tail_end); it != path.rend(); ++it)
+        {
+            I next = v[*it];
+            g.component[*it] = g.component[next];
+            g.distance[*it] = g.distance[next] + 1;
+            g.entry[*it] = g.entry[next];
+        }
+        path.clear();
+    }
+
+    g.duplicates = count_duplicates(v);
+    return g;
+}
@@ -1,58 +1,9 @@
 #pragma once
-#include <random>
 #include <cmath>
-#include <concepts>
 #include <SFML/Graphics.hpp>
 
-template <std::integral I>
-class RandomGen
-{
-public:
-    RandomGen(I min, I max):
-        dist(min, max),
-        gen(std::random_device{}())
-    {}
-
-    I operator()()
-    {
-        return dist(gen);
-    }
-
-private:
-    std::uniform_int_distribution<I> dist;
-    std::mt19937 gen;
-};
-template <std::integral I>
-void fill_with_random(std::vector<I>& v, I min, I max)
-{
-    RandomGen<I> gen(min, max);
-    std::ranges::generate(v, gen);
-}
-
-template <std::integral I>
-auto find_duplicates(const std::vector<I>& v)
-{
-    I tortoise=0, hare=0;
-
-    do
-    {
-        tortoise = v[tortoise];
-        hare = v[v[hare]];
-    } while(tortoise != hare);
-
-    I ptr1 = 0;
-    I ptr2 = hare;
-
-    while(ptr1 != ptr2)
-    {
-        ptr1 = v[ptr1];
-        ptr2 = v[ptr2];
-    }
-    return ptr2;
-}
-
 // hue: 0-360°; sat: 0.f-1.f; val: 0.f-1.f
-sf::Color hsv(int hue, float sat, float val)
+inline sf::Color hsv(int hue, float sat, float val)
 {
   hue %= 360;
   while(hue<0) hue += 360;
@@ -82,12 +33,12 @@ sf::Color hsv(int hue, float sat, float val)
   }
 }
 
-float vector_mod(sf::Vector2f v)
+inline float vector_mod(sf::Vector2f v)
 {
     return std::sqrt(v.x*v.x + v.y*v.y);
 }
 
-void change_size_to(sf::Vector2f& v, float new_size)
+inline void change_size_to(sf::Vector2f& v, float new_size)
 {
     float size = vector_mod(v);
     if (size==0)
@@ -96,15 +47,15 @@ void change_size_to(sf::Vector2f& v, float new_size)
     }
     v *= new_size/vector_mod(v);
 }
-sf::Vector2f turn_vector(sf::Vector2f v, float rad)
+inline sf::Vector2f turn_vector(sf::Vector2f v, float rad)
 {
     return {v.x * std::cos(rad) - v.y * std::sin(rad), v.x * std::sin(rad) + v.y * std::cos(rad)};
 }
-float distance(sf::Vector2f p1, sf::Vector2f p2)
+inline float distance(sf::Vector2f p1, sf::Vector2f p2)
 {
     return vector_mod(p2-p1);
 }
-sf::VertexArray get_triangle_for_arrow(sf::Vertex p1, sf::Vertex p2, float triangle_height = 20.f)
+inline sf::VertexArray get_triangle_for_arrow(sf::Vertex p1, sf::Vertex p2, float triangle_height = 20.f)
 {
     sf::Vector2f v = p1.position-p2.position;
     if (v == sf::Vector2f(0,0))
@@ -126,7 +77,7 @@ sf::VertexArray get_triangle_for_arrow(sf::Vertex p1, sf::Vertex p2, float trian
     return triangle_vertex;
 }
 
-void draw_arrow(sf::RenderWindow& window, sf::Vector2f p1, sf::Vector2f p2, sf::Color c, float triangle_height = 20.)
+inline void draw_arrow(sf::RenderWindow& window, sf::Vector2f p1, sf::Vector2f p2, sf::Color c, float triangle_height = 20.)
 {
     sf::VertexArray line(sf::Lines, 2);
     line[0] = p1;
@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <variant>
+#include <concepts>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+#include <limits>
+#include <algorithm>
+#include "cycle_detection.hpp"
+#include "validation.hpp"
+
+// Successor array stored with ceil(log2 n) bits per entry. Entries may straddle
+// two words; one padding word keeps the two-word read in bounds.
+class PackedIndexArray
+{
+public:
+    using value_type = uint64_t;
+
+    PackedIndexArray() = default;
+    PackedIndexArray(size_t n, unsigned bits_per_entry):
+        n(n),
+        bits(bits_per_entry),
+        mask(bits_per_entry == 64 ? ~uint64_t(0) : (uint64_t(1) << bits_per_entry) - 1),
+        words((n*bits_per_entry + 63)/64 + 1)
+    {}
+
+    // Throws ValidationError on an entry outside [0, n), which would not fit
+    // its bits.
+    template <std::integral I>
+    explicit PackedIndexArray(const std::vector<I>& v):
+        PackedIndexArray(v.size(), bits_for(v.size()))
+    {
+        validate_indices(v);
+        for (size_t i = 0; i < v.size(); i++)
+        {
+            set(i, static_cast<uint64_t>(v[i]));
+        }
+    }
+
+    // Bits needed to store any index below n.
+    static unsigned bits_for(size_t n)
+    {
+        return std::max<unsigned>(1, std::bit_width(n > 0 ? n - 1 : 0));
+    }
+
+    uint64_t operator[](size_t i) const
+    {
+        size_t bit = i*bits;
+        size_t w = bit/64;
+        unsigned offset = bit%64;
+        // The split shift avoids an undefined shift by 64 when offset == 0.
+        uint64_t value = (words[w] >> offset) | ((words[w + 1] << 1) << (63 - offset));
+        return value & mask;
+    }
+
+    // Only the low bits_per_entry() bits of value are stored, so a wider value
+    // cannot spill into its neighbours.
+    void set(size_t i, uint64_t value)
+    {
+        value &= mask;
+        size_t bit = i*bits;
+        size_t w = bit/64;
+        unsigned offset = bit%64;
+        words[w] = (words[w] & ~(mask << offset)) | (value << offset);
+        if (offset + bits > 64)
+        {
+            unsigned spill = 64 - offset;
+            words[w + 1] = (words[w + 1] & ~(mask >> spill)) | (value >> spill);
+        }
+    }
+
+    size_t size() const
+    {
+        return n;
+    }
+    unsigned bits_per_entry() const
+    {
+        return bits;
+    }
+
+private:
+    size_t n = 0;
+    unsigned bits = 1;
+    uint64_t mask = 1;
+    std::vector<uint64_t> words;
+};
+
+using IndexStorage = std::variant<std::vector<uint8_t>,
+                                  std::vector<uint16_t>,
+                                  std::vector<uint32_t>,
+                                  std::vector<uint64_t>,
+                                  PackedIndexArray>;
+
+template <std::unsigned_integral W, std::integral I>
+std::vector<W> narrow_indices(const std::vector<I>& v)
+{
+    return std::vector<W>(v.begin(), v.end());
+}
+
+// Copies v into the narrowest word type able to hold every index below
+// v.size(), or into the bit-packed form when `packed` is set. Throws
+// ValidationError on an entry outside [0, n), which would not survive the
+// narrowing.
+template <std::integral I>
+IndexStorage make_index_storage(const std::vector<I>& v, bool packed = false)
+{
+    if (packed)
+    {
+        return PackedIndexArray(v);
+    }
+    validate_indices(v);
+    unsigned bits = PackedIndexArray::bits_for(v.size());
+    if (bits <= 8)
+    {
+        return narrow_indices<uint8_t>(v);
+    }
+    if (bits <= 16)
+    {
+        return narrow_indices<uint16_t>(v);
+    }
+    if (bits <= 32)
+    {
+        return narrow_indices<uint32_t>(v);
+    }
+    return narrow_indices<uint64_t>(v);
+}
+
+template <std::integral I>
+RhoResult<uint64_t> widen_result(const RhoResult<I>& r)
+{
+    return {static_cast<uint64_t>(r.meeting), static_cast<uint64_t>(r.entry), r.mu, r.lambda,
+            static_cast<uint64_t>(r.tail_predecessor), static_cast<uint64_t>(r.cycle_predecessor),
+            r.evaluations};
+}
+
+template <class Engine = Floyd>
+RhoResult<uint64_t> detect_cycle(const IndexStorage& storage, uint64_t start = 0)
+{
+    return std::visit([&](const auto& v)
+    {
+        using Index = typename std::decay_t<decltype(v)>::value_type;
+        return widen_result(detect_cycle<Engine>(v, static_cast<Index>(start)));
+    }, storage);
+}
+
+template <class Engine = Floyd>
+uint64_t find_duplicates(const IndexStorage& storage)
+{
+    return detect_cycle<Engine>(storage).entry;
+}
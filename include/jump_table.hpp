@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <concepts>
+#include <stdexcept>
+#include <string>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "rho_index.hpp"
+
+// Jump pointers for k-th successor queries, f^k(x) in O(log k) lookups.
+// Level j stores f^(2^(stride*j)); stride 1 is plain binary lifting, larger
+// strides keep every stride-th power of two only. That divides the memory by
+// stride, and a query applies each level up to 2^stride - 1 times instead of
+// once.
+template <std::integral I>
+class JumpTable
+{
+public:
+    // Levels cover every k <= max_steps (default n); larger k are rejected,
+    // CycleJumpTable answers those in O(log n).
+    explicit JumpTable(const std::vector<I>& v, uint64_t max_steps = 0, unsigned stride = 1):
+        n(v.size()),
+        stride(stride),
+        limit(max_steps ? max_steps : v.size())
+    {
+        if (stride == 0 or stride >= 64)
+        {
+            throw std::invalid_argument("Jump table stride must be in [1, 63]");
+        }
+        unsigned bits = std::bit_width(std::max<uint64_t>(limit, 1));
+        size_t levels = (bits + stride - 1)/stride;
+        table.reserve(levels*n);
+        table.assign(v.begin(), v.end());
+        for (size_t j = 1; j < levels; j++)
+        {
+            // Squaring the previous level stride times.
+            std::vector<I> power(table.end() - n, table.end()), squared(n);
+            for (unsigned s = 0; s < stride; s++)
+            {
+                for (size_t x = 0; x < n; x++)
+                {
+                    squared[x] = power[power[x]];
+                }
+                power.swap(squared);
+            }
+            table.insert(table.end(), power.begin(), power.end());
+        }
+    }
+
+    size_t levels() const
+    {
+        return n ? table.size()/n : 0;
+    }
+    size_t memory_bytes() const
+    {
+        return table.size()*sizeof(I);
+    }
+
+    uint64_t max_steps() const
+    {
+        return limit;
+    }
+
+    I operator()(I x, uint64_t k) const
+    {
+        if (k > limit)
+        {
+            throw std::out_of_range("k = " + std::to_string(k) + " exceeds the table's " +
+                                    std::to_string(limit) + " steps; use CycleJumpTable for larger k");
+        }
+        const uint64_t digit_mask = (uint64_t(1) << stride) - 1;
+        for (size_t j = 0; k > 0; j++, k >>= stride)
+        {
+            for (uint64_t d = k & digit_mask; d > 0; d--)
+            {
+                x = level(j)[x];
+            }
+        }
+        return x;
+    }
+
+private:
+    const I* level(size_t j) const
+    {
+        return table.data() + j*n;
+    }
+
+    size_t n;
+    unsigned stride;
+    uint64_t limit;
+    std::vector<I> table;   // levels() rows of n entries
+};
+
+// Jump table that never needs more than n steps: once the walk from x has
+// passed its tail, k is reduced modulo the cycle length, so any k up to
+// 2^64 costs the same O(log n) lookups.
+template <std::integral I>
+class CycleJumpTable
+{
+public:
+    explicit CycleJumpTable(const std::vector<I>& v, unsigned stride = 1):
+        rho(v),
+        jumps(v, v.size(), stride)
+    {}
+
+    I operator()(I x, uint64_t k) const
+    {
+        uint64_t tail = rho.tail_length(x);
+        if (k <= tail)
+        {
+            return jumps(x, k);
+        }
+        return jumps(rho.entry(x), (k - tail) % rho.cycle_length(x));
+    }
+
+    // Whether f^k(x) == x, i.e. x lies on a cycle whose length divides k.
+    bool is_periodic(I x, uint64_t k) const
+    {
+        return k == 0 or (rho.on_cycle(x) and k % rho.cycle_length(x) == 0);
+    }
+
+    const RhoIndex<I>& index() const
+    {
+        return rho;
+    }
+
+private:
+    RhoIndex<I> rho;
+    JumpTable<I> jumps;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole file; `advice` is passed to madvise().
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path, int advice = MADV_NORMAL)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Can't stat " + path);
+        }
+        length = st.st_size;
+        if (length > 0)
+        {
+            base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (base == MAP_FAILED)
+        {
+            base = nullptr;
+            throw std::runtime_error("Can't map " + path);
+        }
+        if (base)
+        {
+            ::madvise(base, length, advice);
+        }
+    }
+
+    MappedFile(MappedFile&& other) noexcept:
+        base(std::exchange(other.base, nullptr)),
+        length(std::exchange(other.length, 0))
+    {}
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        std::swap(base, other.base);
+        std::swap(length, other.length);
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        if (base)
+        {
+            ::munmap(base, length);
+        }
+    }
+
+    const void* data() const
+    {
+        return base;
+    }
+    size_t size() const
+    {
+        return length;
+    }
+    std::string_view text() const
+    {
+        return {static_cast<const char*>(base), length};
+    }
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,293 @@
+#pragma once
+#include <vector>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include "functional_graph.hpp"
+#include "work_stealing_pool.hpp"
+
+// Same result as analyze_functional_graph(), in O(n) work spread over the
+// pool, with one n-entry in-degree array and one byte of state per node on
+// top of the output:
+//   1. in-degrees, which also give the duplicates;
+//   2. peeling: walks from every leaf remove each node whose in-degree drops
+//      to 0, so exactly the cycle nodes are left;
+//   3. cycle labelling: walks over the cycle nodes, each claiming nodes until
+//      it runs into a claimed one. A walk that gets back to its start closed
+//      its cycle; the rare cycles split between concurrent walks are joined
+//      afterwards;
+//   4. tail labelling: walks from every leaf, claiming nodes until they reach
+//      a labelled one, label their path on the way back. A walk that runs
+//      into a node claimed by another walk waits for its label.
+// Separate trees and cycles go to separate threads, but a single chain or
+// cycle is walked by one thread, so an input made of one long path does not
+// scale. Each phase is another dependent chase over the graph where the
+// serial analyzer needs one, so a pool of a few threads only breaks even;
+// below parallel_graph_min_nodes or on a single-thread pool the serial walk
+// is used instead.
+constexpr size_t parallel_graph_min_nodes = size_t(1) << 20;
+
+template <std::integral I>
+FunctionalGraph<I> analyze_functional_graph_parallel(const std::vector<I>& v,
+                                                     WorkStealingPool& pool = default_pool())
+{
+    const size_t n = v.size();
+    if (n < parallel_graph_min_nodes or pool.size() < 2)
+    {
+        return analyze_functional_graph(v);
+    }
+    const size_t grain = 1 << 16;
+    const size_t chunks = (n + grain - 1)/grain;
+    FunctionalGraph<I> g;
+
+    auto sweep = [&](auto&& body)
+    {
+        pool.parallel_for(0, n, grain, [&](size_t lo, size_t hi)
+        {
+            for (size_t x = lo; x < hi; x++)
+            {
+                body(x);
+            }
+        });
+    };
+
+    // Appends make(x) for every x matching keep(x), in increasing x.
+    auto collect = [&](auto& out, auto&& keep, auto&& make)
+    {
+        std::vector<std::remove_reference_t<decltype(out)>> parts(chunks);
+        pool.parallel_for(0, n, grain, [&](size_t lo, size_t hi)
+        {
+            for (size_t x = lo; x < hi; x++)
+            {
+                if (keep(x))
+                {
+                    parts[lo/grain].push_back(make(x));
+                }
+            }
+        });
+        for (auto& part: parts)
+        {
+            out.insert(out.end(), part.begin(), part.end());
+        }
+    };
+
+    // 1. At least 32 bits: n entries of a narrow type can all point at one value.
+    std::vector<std::common_type_t<std::make_unsigned_t<I>, uint32_t>> in_degree(n);
+    sweep([&](size_t x){ std::atomic_ref(in_degree[v[x]]).fetch_add(1, std::memory_order_relaxed); });
+    collect(g.duplicates, [&](size_t x)
+    {
+        return in_degree[x] > 1;
+    }, [&](size_t x)
+    {
+        return std::pair<I, size_t>(static_cast<I>(x), in_degree[x]);
+    });
+
+    enum : uint8_t { cyclic, leaf, tail, claimed, labelled };
+    std::vector<uint8_t> state(n);
+    auto state_of = [&](size_t x)
+    {
+        return std::atomic_ref(state[x]);
+    };
+    sweep([&](size_t x){ state[x] = in_degree[x] == 0 ? leaf : cyclic; });
+
+    // 2. Only the walk that takes a node's in-degree to 0 goes on through it.
+    sweep([&](size_t x)
+    {
+        if (state_of(x).load(std::memory_order_relaxed) != leaf)
+        {
+            return;
+        }
+        for (size_t y = v[x]; std::atomic_ref(in_degree[y]).fetch_sub(1, std::memory_order_relaxed) == 1;
+             y = v[y])
+        {
+            state_of(y).store(tail, std::memory_order_relaxed);
+        }
+    });
+
+    // 3. A walk can only stop on the start of another walk, as the node
+    // before any node it meets is its own. Until the cycles are numbered,
+    // component holds the start of the walk that claimed a cycle node.
+    struct Walk
+    {
+        I start;
+        I stop;
+        I smallest;
+        size_t length;
+    };
+    g.component.resize(n);
+    g.distance.resize(n);
+    g.entry.resize(n);
+    std::vector<std::vector<Walk>> parts(chunks);
+    sweep([&](size_t x)
+    {
+        uint8_t expected = cyclic;
+        if (!state_of(x).compare_exchange_strong(expected, claimed, std::memory_order_relaxed))
+        {
+            return;
+        }
+        Walk w{static_cast<I>(x), static_cast<I>(x), static_cast<I>(x), 1};
+        g.component[x] = w.start;
+        for (size_t y = v[x]; ; y = v[y], w.length++)
+        {
+            expected = cyclic;
+            if (!state_of(y).compare_exchange_strong(expected, claimed, std::memory_order_relaxed))
+            {
+                w.stop = static_cast<I>(y);
+                break;
+            }
+            g.component[y] = w.start;
+            w.smallest = std::min(w.smallest, static_cast<I>(y));
+        }
+        parts[x/grain].push_back(w);
+    });
+
+    std::vector<Walk> walks;
+    for (auto& part: parts)
+    {
+        walks.insert(walks.end(), part.begin(), part.end());
+    }
+    parts = {};
+    // Cycles in order of discovery, renumbered at the end.
+    std::vector<CycleInfo<I>> found;
+    std::vector<I> cycle_of_walk(walks.size());
+    std::vector<size_t> open;   // walks that stopped on another walk, by start
+    for (size_t k = 0; k < walks.size(); k++)
+    {
+        if (walks[k].stop == walks[k].start)
+        {
+            cycle_of_walk[k] = static_cast<I>(found.size());
+            found.push_back({walks[k].smallest, walks[k].length});
+        }
+        else
+        {
+            open.push_back(k);
+        }
+    }
+    auto walk_from = [&](I start)
+    {
+        return *std::ranges::lower_bound(open, start, {}, [&](size_t k){ return walks[k].start; });
+    };
+    std::vector<bool> joined(open.size());
+    for (size_t j = 0; j < open.size(); j++)
+    {
+        if (joined[j])
+        {
+            continue;
+        }
+        CycleInfo<I> c{walks[open[j]].smallest, 0};
+        size_t k = open[j];
+        do
+        {
+            joined[std::ranges::lower_bound(open, k) - open.begin()] = true;
+            cycle_of_walk[k] = static_cast<I>(found.size());
+            c.representative = std::min(c.representative, walks[k].smallest);
+            c.length += walks[k].length;
+            k = walk_from(walks[k].stop);
+        } while (k != open[j]);
+        found.push_back(c);
+    }
+
+    // The start of each walk passes its cycle number on to the walk's nodes.
+    pool.parallel_for(0, walks.size(), grain, [&](size_t lo, size_t hi)
+    {
+        for (size_t k = lo; k < hi; k++)
+        {
+            g.distance[walks[k].start] = cycle_of_walk[k];
+        }
+    });
+    sweep([&](size_t x)
+    {
+        if (state[x] == claimed)
+        {
+            g.component[x] = g.distance[g.component[x]];
+        }
+    });
+    sweep([&](size_t x)
+    {
+        if (state[x] == claimed)
+        {
+            g.distance[x] = 0;
+            g.entry[x] = static_cast<I>(x);
+            state[x] = labelled;
+        }
+    });
+
+    // 4. Tail nodes copy their labels from their successor, so every walk
+    // labels its path backwards from the labelled node it reached.
+    pool.parallel_for(0, n, grain, [&](size_t lo, size_t hi)
+    {
+        std::vector<I> path;
+        for (size_t x = lo; x < hi; x++)
+        {
+            if (state_of(x).load(std::memory_order_relaxed) != leaf)
+            {
+                continue;
+            }
+            size_t y = x;
+            while (true)
+            {
+                uint8_t s = state_of(y).load(std::memory_order_acquire);
+                if (s == claimed)
+                {
+                    // Another walk is on its way to the cycle through y.
+                    while (state_of(y).load(std::memory_order_acquire) != labelled)
+                    {
+                        std::this_thread::yield();
+                    }
+                    break;
+                }
+                if (s == labelled)
+                {
+                    break;
+                }
+                if (state_of(y).compare_exchange_strong(s, claimed, std::memory_order_relaxed))
+                {
+                    path.push_back(static_cast<I>(y));
+                    y = v[y];
+                }
+            }
+            for (auto it = path.rbegin(); it != path.rend(); ++it)
+            {
+                I next = v[*it];
+                g.component[*it] = g.component[next];
+                g.distance[*it] = g.distance[next] + 1;
+                g.entry[*it] = g.entry[next];
+                state_of(*it).store(labelled, std::memory_order_release);
+            }
+            path.clear();
+        }
+    });
+
+    // Components are numbered by their smallest node, as the serial walk
+    // discovers them in that order.
+    std::vector<I> first_node(found.size(), std::numeric_limits<I>::max());
+    sweep([&](size_t x)
+    {
+        std::atomic_ref slot(first_node[g.component[x]]);
+        I current = slot.load(std::memory_order_relaxed);
+        while (static_cast<I>(x) < current and
+               !slot.compare_exchange_weak(current, static_cast<I>(x), std::memory_order_relaxed))
+        {}
+    });
+    std::vector<std::pair<I, I>> order;   // first node, cycle in order of discovery
+    for (size_t c = 0; c < found.size(); c++)
+    {
+        order.emplace_back(first_node[c], static_cast<I>(c));
+    }
+    std::ranges::sort(order);
+
+    std::vector<I>& id_of = first_node;
+    for (size_t id = 0; id < order.size(); id++)
+    {
+        id_of[order[id].second] = static_cast<I>(id);
+        g.cycles.push_back(found[order[id].second]);
+    }
+    sweep([&](size_t x){ g.component[x] = id_of[g.component[x]]; });
+    return g;
+}
@@ -0,0 +1,324 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+using u128 = unsigned __int128;
+
+// Full product of two words as {high, low}.
+inline std::pair<uint64_t, uint64_t> mul_wide(uint64_t a, uint64_t b)
+{
+    u128 p = u128(a)*b;
+    return {uint64_t(p >> 64), uint64_t(p)};
+}
+
+inline std::pair<u128, u128> mul_wide(u128 a, u128 b)
+{
+    u128 a_lo = uint64_t(a), a_hi = a >> 64;
+    u128 b_lo = uint64_t(b), b_hi = b >> 64;
+    u128 lo_lo = a_lo*b_lo, hi_lo = a_hi*b_lo, lo_hi = a_lo*b_hi, hi_hi = a_hi*b_hi;
+    u128 middle = (lo_lo >> 64) + uint64_t(hi_lo) + uint64_t(lo_hi);
+    u128 low = (middle << 64) | uint64_t(lo_lo);
+    u128 high = hi_hi + (hi_lo >> 64) + (lo_hi >> 64) + (middle >> 64);
+    return {high, low};
+}
+
+template <class U>
+unsigned trailing_zeros(U x)
+{
+    if constexpr (std::is_same_v<U, u128>)
+    {
+        return uint64_t(x) != 0 ? __builtin_ctzll(uint64_t(x)) : 64 + __builtin_ctzll(uint64_t(x >> 64));
+    }
+    else
+    {
+        return __builtin_ctzll(x);
+    }
+}
+
+// Binary gcd; std::gcd does not accept unsigned __int128 in strict modes.
+template <class U>
+U binary_gcd(U a, U b)
+{
+    if (a == 0 or b == 0)
+    {
+        return a | b;
+    }
+    unsigned shift = trailing_zeros(a | b);
+    a >>= trailing_zeros(a);
+    while (b != 0)
+    {
+        b >>= trailing_zeros(b);
+        if (a > b)
+        {
+            std::swap(a, b);
+        }
+        b -= a;
+    }
+    return a << shift;
+}
+
+// Arithmetic modulo an odd n in Montgomery form, R = 2^bits(U). Reduction
+// uses the signed variant (t - m*n)/R, which holds for any odd n < R.
+template <class U>
+class Montgomery
+{
+public:
+    static constexpr unsigned bits = sizeof(U)*8;
+
+    explicit Montgomery(U modulus):
+        n(modulus)
+    {
+        // Newton iteration doubles the correct low bits of n^-1 each round,
+        // starting from 3 correct bits (n*n == 1 mod 8 for odd n).
+        n_inv = n;
+        for (unsigned correct = 3; correct < bits; correct *= 2)
+        {
+            n_inv *= 2 - n*n_inv;
+        }
+        // R mod n, then doubled bits times to get R^2 mod n.
+        r2 = U(U(0) - n) % n;
+        for (unsigned i = 0; i < bits; i++)
+        {
+            r2 = add(r2, r2);
+        }
+    }
+
+    U modulus() const
+    {
+        return n;
+    }
+    U to(U x) const
+    {
+        return mul(x % n, r2);
+    }
+    U from(U x) const
+    {
+        return mul(x, 1);
+    }
+
+    U mul(U a, U b) const
+    {
+        auto [high, low] = mul_wide(a, b);
+        U m = low*n_inv;
+        U mn_high = mul_wide(m, n).first;
+        return high >= mn_high ? high - mn_high : high - mn_high + n;
+    }
+    U add(U a, U b) const
+    {
+        U s = a + b;
+        return (s < a or s >= n) ? s - n : s;
+    }
+    U pow(U base, U e) const
+    {
+        U result = to(1);
+        for (; e > 0; e >>= 1)
+        {
+            if (e & 1)
+            {
+                result = mul(result, base);
+            }
+            base = mul(base, base);
+        }
+        return result;
+    }
+
+private:
+    U n, n_inv, r2;
+};
+
+// Miller-Rabin. The seven 64-bit bases are deterministic below 2^64; above
+// that the first twenty primes leave no known pseudoprime, but the test is
+// probabilistic in principle.
+template <class U>
+bool is_prime(U n)
+{
+    constexpr uint32_t small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47,
+                                         53, 59, 61, 67, 71};
+    if (n < 2)
+    {
+        return false;
+    }
+    for (uint32_t p: small_primes)
+    {
+        if (n % p == 0)
+        {
+            return n == p;
+        }
+    }
+    if (n < 73*73)
+    {
+        return true;
+    }
+
+    Montgomery<U> mont(n);
+    U d = n - 1;
+    unsigned s = trailing_zeros(d);
+    d >>= s;
+    U one = mont.to(1), minus_one = mont.to(n - 1);
+    auto witness = [&](U a)
+    {
+        U x = mont.pow(mont.to(a), d);
+        if (x == one or x == minus_one)
+        {
+            return false;
+        }
+        for (unsigned i = 1; i < s; i++)
+        {
+            x = mont.mul(x, x);
+            if (x == minus_one)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (n <= ~uint64_t(0))
+    {
+        for (uint64_t a: {2ull, 325ull, 9375ull, 28178ull, 450775ull, 9780504ull, 1795265022ull})
+        {
+            if (a % n != 0 and witness(a % n))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (uint32_t a: small_primes)
+    {
+        if (witness(a))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Brent's variant of Pollard's rho on x -> x^2 + c (mod n). Like the Brent
+// cycle engine the tortoise is parked at powers of two while the hare runs,
+// but a cycle mod an unknown factor p shows up as gcd(|x - y|, n) > 1
+// instead of x == y. The differences are multiplied together and the gcd is
+// taken once per `batch` steps; on overshoot the last batch is replayed one
+// step at a time. Returns n when the polynomial fails or `stop` is raised.
+template <class U>
+U pollard_brent(U n, U c, const std::atomic<bool>& stop, size_t batch = 128)
+{
+    Montgomery<U> mont(n);
+    U cm = mont.to(c);
+    auto f = [&](U x){ return mont.add(mont.mul(x, x), cm); };
+    auto difference = [](U a, U b){ return a > b ? a - b : b - a; };
+
+    U y = mont.to(2), x = y, saved = y;
+    U product = mont.to(1);
+    U g = 1;
+    for (size_t power = 1; g == 1; power *= 2)
+    {
+        if (stop.load(std::memory_order_relaxed))
+        {
+            return n;
+        }
+        x = y;
+        for (size_t i = 0; i < power; i++)
+        {
+            y = f(y);
+        }
+        for (size_t k = 0; k < power and g == 1 and !stop.load(std::memory_order_relaxed); k += batch)
+        {
+            saved = y;
+            for (size_t i = 0; i < std::min(batch, power - k); i++)
+            {
+                y = f(y);
+                product = mont.mul(product, difference(x, y));
+            }
+            g = binary_gcd(product, n);
+        }
+    }
+    if (g == n)
+    {
+        do
+        {
+            saved = f(saved);
+            g = binary_gcd(difference(x, saved), n);
+        } while (g == 1);
+    }
+    return g;
+}
+
+// A nontrivial factor of the odd composite n. Threads run independent
+// polynomials c = 1, 2, 3, ... and the first to succeed stops the others.
+template <class U>
+U find_factor(U n, size_t threads = std::thread::hardware_concurrency())
+{
+    threads = std::max<size_t>(1, threads);
+    std::atomic<bool> stop = false;
+    std::vector<U> found(threads, n);
+
+    auto search = [&](size_t t)
+    {
+        for (U c = t + 1; !stop.load(std::memory_order_relaxed); c += threads)
+        {
+            U g = pollard_brent(n, c, stop);
+            if (g != n and g != 1)
+            {
+                found[t] = g;
+                stop = true;
+            }
+        }
+    };
+    if (threads == 1)
+    {
+        search(0);
+    }
+    else
+    {
+        std::vector<std::jthread> pool;
+        for (size_t t = 0; t < threads; t++)
+        {
+            pool.emplace_back(search, t);
+        }
+    }
+    return *std::ranges::find_if(found, [n](U g){ return g != n; });
+}
+
+// Prime factorization in increasing order: small primes by trial division,
+// then Pollard-Brent splitting of whatever remains.
+template <class U>
+std::vector<U> factorize(U n, size_t threads = std::thread::hardware_concurrency())
+{
+    std::vector<U> factors;
+    for (U p = 2; p < 1000 and p*p <= n; p += 1 + (p > 2))
+    {
+        while (n % p == 0)
+        {
+            factors.push_back(p);
+            n /= p;
+        }
+    }
+
+    std::vector<U> pending;
+    if (n > 1)
+    {
+        pending.push_back(n);
+    }
+    while (!pending.empty())
+    {
+        U m = pending.back();
+        pending.pop_back();
+        if (is_prime(m))
+        {
+            factors.push_back(m);
+            continue;
+        }
+        U d = find_factor(m, threads);
+        pending.push_back(d);
+        pending.push_back(m/d);
+    }
+    std::ranges::sort(factors);
+    return factors;
+}
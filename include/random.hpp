@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <limits>
+#include <concepts>
+#include <type_traits>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "work_stealing_pool.hpp"
+
+inline uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27))*0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+// xoshiro256** (Blackman and Vigna): 256 bits of state, a few shifts and
+// adds per number. jump() advances by 2^128 steps, so one seed gives up to
+// 2^128 non-overlapping per-thread streams.
+class Xoshiro256
+{
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed)
+    {
+        for (uint64_t& word: s)
+        {
+            seed += 0x9e3779b97f4a7c15;
+            word = splitmix64(seed);
+        }
+    }
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+    static constexpr result_type max()
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()()
+    {
+        uint64_t result = std::rotl(s[1]*5, 7)*9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = std::rotl(s[3], 45);
+        return result;
+    }
+
+    void jump()
+    {
+        constexpr uint64_t polynomial[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                           0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+        uint64_t jumped[4] = {};
+        for (uint64_t word: polynomial)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (word & (uint64_t(1) << b))
+                {
+                    for (int i = 0; i < 4; i++)
+                    {
+                        jumped[i] ^= s[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            s[i] = jumped[i];
+        }
+    }
+
+private:
+    uint64_t s[4];
+};
+
+// Uniform in [0, range) by Lemire's multiply-shift: the high word of x*range
+// is already uniform except for a bias on the low word's first
+// 2^64 mod range values, and the division that finds that threshold only
+// runs on the rare draw that could be biased. range == 0 means all 2^64.
+template <class G>
+uint64_t bounded(G& gen, uint64_t range)
+{
+    if (range == 0)
+    {
+        return gen();
+    }
+    unsigned __int128 m = static_cast<unsigned __int128>(gen())*range;
+    if (static_cast<uint64_t>(m) < range)
+    {
+        uint64_t threshold = -range % range;
+        while (static_cast<uint64_t>(m) < threshold)
+        {
+            m = static_cast<unsigned __int128>(gen())*range;
+        }
+    }
+    return static_cast<uint64_t>(m >> 64);
+}
+
+template <std::integral I>
+class RandomGen
+{
+public:
+    RandomGen(I min, I max):
+        RandomGen(min, max, std::random_device{}())
+    {}
+    RandomGen(I min, I max, uint64_t seed):
+        min(min),
+        range(static_cast<uint64_t>(span(min, max)) + 1),
+        gen(seed)
+    {}
+
+    I operator()()
+    {
+        return static_cast<I>(min + static_cast<std::make_unsigned_t<I>>(bounded(gen, range)));
+    }
+
+    // Moves to the next of the seed's non-overlapping streams.
+    void jump()
+    {
+        gen.jump();
+    }
+
+private:
+    // max - min computed unsigned, as the signed difference can overflow.
+    static std::make_unsigned_t<I> span(I min, I max)
+    {
+        using U = std::make_unsigned_t<I>;
+        return static_cast<U>(static_cast<U>(max) - static_cast<U>(min));
+    }
+
+    I min;
+    uint64_t range;   // 0 for the full 64-bit range
+    Xoshiro256 gen;
+};
+
+// Every block of 2^16 entries draws from its own generator, seeded from the
+// seed and the block number, so the output only depends on the seed and not
+// on how blocks are spread over threads.
+template <std::integral I>
+void fill_with_random(std::vector<I>& v, I min, I max, uint64_t seed = std::random_device{}(),
+                      WorkStealingPool& pool = default_pool())
+{
+    constexpr size_t block = 1 << 16;
+    pool.parallel_for(0, (v.size() + block - 1)/block, 1, [&](size_t lo, size_t hi)
+    {
+        for (size_t b = lo; b < hi; b++)
+        {
+            RandomGen<I> gen(min, max, splitmix64(seed ^ splitmix64(b)));
+            for (size_t i = b*block; i < std::min(v.size(), (b + 1)*block); i++)
+            {
+                v[i] = gen();
+            }
+        }
+    });
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <vector>
+#include <concepts>
+#include <cstdint>
+#include <cstddef>
+#include "cycle_detection.hpp"
+#include "validation.hpp"
+
+// Permutation of the node labels into the order chases visit them, so that
+// consecutive lookups of a chase hit neighbouring entries instead of random
+// cache lines and pages:
+//  - the rho from 0 comes first, in walk order, so the chase that
+//    find_duplicates() does reads the relabelled array front to back,
+//  - every other component follows with its cycle in walk order,
+//  - then the trees hanging off each component, in depth-first preorder over
+//    the predecessor lists, so a chain x -> f(x) -> ... towards the cycle
+//    gets consecutive, descending labels.
+// Worth its O(n) one-time cost and the two n-entry label maps it keeps only
+// when the array serves many chases.
+template <std::integral I>
+class LocalityRelabeling
+{
+public:
+    explicit LocalityRelabeling(const std::vector<I>& v):
+        new_label(v.size()),
+        old_label(v.size())
+    {
+        validate_indices(v);
+        const size_t n = v.size();
+        auto next = [&](size_t x){ return static_cast<size_t>(v[x]); };
+
+        // Predecessor lists in CSR form: preds[offsets[y], offsets[y + 1]).
+        std::vector<size_t> offsets(n + 1);
+        for (size_t x = 0; x < n; x++)
+        {
+            offsets[next(x) + 1]++;
+        }
+        for (size_t y = 0; y < n; y++)
+        {
+            offsets[y + 1] += offsets[y];
+        }
+        std::vector<I> preds(n);
+        {
+            std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t x = 0; x < n; x++)
+            {
+                preds[fill[next(x)]++] = static_cast<I>(x);
+            }
+        }
+
+        enum : uint8_t { unseen, walked, placed };
+        std::vector<uint8_t> state(n, unseen);
+        size_t count = 0;
+        auto place = [&](size_t x)
+        {
+            state[x] = placed;
+            new_label[x] = static_cast<I>(count);
+            old_label[count++] = static_cast<I>(x);
+        };
+        std::vector<size_t> stack;
+        // Labels the trees hanging off the nodes placed from `first` on.
+        auto place_trees = [&](size_t first)
+        {
+            for (size_t root = first, roots_end = count; root < roots_end; root++)
+            {
+                stack.push_back(static_cast<size_t>(old_label[root]));
+                while (!stack.empty())
+                {
+                    size_t y = stack.back();
+                    stack.pop_back();
+                    if (state[y] != placed)
+                    {
+                        place(y);
+                    }
+                    for (size_t p = offsets[y]; p < offsets[y + 1]; p++)
+                    {
+                        if (state[static_cast<size_t>(preds[p])] != placed)
+                        {
+                            stack.push_back(static_cast<size_t>(preds[p]));
+                        }
+                    }
+                }
+            }
+        };
+
+        if (n > 0)
+        {
+            // The whole rho before any tree, to keep it in walk order.
+            for (size_t x = 0; state[x] != placed; x = next(x))
+            {
+                place(x);
+            }
+            place_trees(0);
+        }
+        for (size_t start = 0; start < n; start++)
+        {
+            if (state[start] != unseen)
+            {
+                continue;
+            }
+            // Components are placed whole, so the walk ends on its own cycle.
+            size_t x = start;
+            while (state[x] == unseen)
+            {
+                state[x] = walked;
+                x = next(x);
+            }
+            size_t first = count;
+            do
+            {
+                place(x);
+                x = next(x);
+            } while (state[x] != placed);
+            place_trees(first);
+        }
+    }
+
+    size_t size() const
+    {
+        return new_label.size();
+    }
+    I to_relabeled(I x) const
+    {
+        return new_label[static_cast<size_t>(x)];
+    }
+    I to_original(I y) const
+    {
+        return old_label[static_cast<size_t>(y)];
+    }
+
+    // w[to_relabeled(x)] == to_relabeled(v[x]).
+    std::vector<I> relabel(const std::vector<I>& v) const
+    {
+        std::vector<I> w(v.size());
+        for (size_t y = 0; y < w.size(); y++)
+        {
+            w[y] = to_relabeled(v[static_cast<size_t>(old_label[y])]);
+        }
+        return w;
+    }
+
+    // Maps the nodes of a result on the relabelled array back; lengths and
+    // counts are unchanged by a relabelling.
+    RhoResult<I> to_original(RhoResult<I> r) const
+    {
+        r.meeting = to_original(r.meeting);
+        r.entry = to_original(r.entry);
+        r.tail_predecessor = to_original(r.tail_predecessor);
+        r.cycle_predecessor = to_original(r.cycle_predecessor);
+        return r;
+    }
+
+private:
+    std::vector<I> new_label;
+    std::vector<I> old_label;
+};
+
+// A successor array stored in locality order that answers in the original
+// labels, so callers never see the permutation.
+template <std::integral I>
+class RelabeledArray
+{
+public:
+    explicit RelabeledArray(const std::vector<I>& v):
+        labels(v),
+        array(labels.relabel(v))
+    {}
+
+    template <class Engine = Floyd>
+    RhoResult<I> detect_cycle(I start = 0) const
+    {
+        return labels.to_original(::detect_cycle<Engine>(array, labels.to_relabeled(start)));
+    }
+    template <class Engine = Floyd>
+    I find_duplicates() const
+    {
+        return detect_cycle<Engine>().entry;
+    }
+
+    size_t size() const
+    {
+        return array.size();
+    }
+    const std::vector<I>& relabeled() const
+    {
+        return array;
+    }
+    const LocalityRelabeling<I>& relabeling() const
+    {
+        return labels;
+    }
+
+private:
+    LocalityRelabeling<I> labels;
+    std::vector<I> array;
+};
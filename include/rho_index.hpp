@@ -0,0 +1,203 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <concepts>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include "functional_graph.hpp"
+#include "binary_format.hpp"
+
+// Constant-time answers to "where does the rho from x go" for every start x.
+// Each node owns one packed record, so a query touches a single cache line
+// (plus one for the cycle table, which is small and usually cached).
+template <std::integral I>
+class RhoIndex
+{
+public:
+    struct Node
+    {
+        I entry;   // first cycle node reached from x
+        I tail;    // steps from x to entry, 0 on a cycle
+        I cycle;   // index into the cycle table
+    };
+
+    RhoIndex() = default;
+
+    explicit RhoIndex(const FunctionalGraph<I>& g):
+        nodes(g.component.size()),
+        cycles(g.cycles)
+    {
+        for (size_t x = 0; x < nodes.size(); x++)
+        {
+            nodes[x] = {g.entry[x], g.distance[x], g.component[x]};
+        }
+    }
+
+    explicit RhoIndex(const std::vector<I>& v):
+        RhoIndex(analyze_functional_graph(v))
+    {}
+
+    size_t size() const
+    {
+        return nodes.size();
+    }
+    size_t cycle_count() const
+    {
+        return cycles.size();
+    }
+
+    const Node& node(I x) const
+    {
+        return nodes[x];
+    }
+    size_t tail_length(I x) const
+    {
+        return nodes[x].tail;
+    }
+    I entry(I x) const
+    {
+        return nodes[x].entry;
+    }
+    size_t cycle_length(I x) const
+    {
+        return cycles[nodes[x].cycle].length;
+    }
+    I representative(I x) const
+    {
+        return cycles[nodes[x].cycle].representative;
+    }
+    bool on_cycle(I x) const
+    {
+        return nodes[x].tail == 0;
+    }
+    // Whether the rhos from x and y end in the same cycle.
+    bool same_cycle(I x, I y) const
+    {
+        return nodes[x].cycle == nodes[y].cycle;
+    }
+
+    void save(const std::string& path) const;
+    static RhoIndex load(const std::string& path);
+
+private:
+    std::vector<Node> nodes;
+    std::vector<CycleInfo<I>> cycles;
+};
+
+// On-disk layout: the same 32-byte header as binary successor files, with its
+// own magic and n = number of nodes, followed by the node records, zero
+// padding to 8 bytes, the number of cycles and the cycle table as
+// {representative, length}, all in 64-bit fields (there can be n cycles, and
+// a cycle can hold all n nodes, one more than the index type holds). The
+// checksum covers everything after the header.
+constexpr char rho_index_magic[4] = {'T', 'A', 'H', 'R'};
+constexpr uint32_t rho_index_version = 3;
+
+template <std::integral I>
+void RhoIndex<I>::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("Can't open " + path + " for writing");
+    }
+
+    std::vector<uint64_t> table;
+    table.reserve(1 + 2*cycles.size());
+    table.push_back(cycles.size());
+    for (const auto& c: cycles)
+    {
+        table.push_back(static_cast<uint64_t>(c.representative));
+        table.push_back(c.length);
+    }
+
+    BinaryHeader header{};
+    std::copy(rho_index_magic, rho_index_magic + 4, header.magic);
+    header.version = rho_index_version;
+    header.index_width = sizeof(I);
+    header.n = nodes.size();
+    size_t node_bytes = nodes.size()*sizeof(Node);
+    // checksum64 zero-pads a partial last word, which matches the padding.
+    header.checksum = checksum64(table.data(), table.size()*sizeof(uint64_t), checksum64(nodes.data(), node_bytes));
+
+    const char padding[8] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(nodes.data()), node_bytes);
+    out.write(padding, -node_bytes % 8);
+    out.write(reinterpret_cast<const char*>(table.data()), table.size()*sizeof(uint64_t));
+    if (!out)
+    {
+        throw std::runtime_error("Failed writing " + path);
+    }
+}
+
+template <std::integral I>
+RhoIndex<I> RhoIndex<I>::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("Can't open " + path);
+    }
+    BinaryHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in or !std::equal(header.magic, header.magic + 4, rho_index_magic) or
+        header.version != rho_index_version or header.index_width != sizeof(I))
+    {
+        throw std::runtime_error(path + " is not a rho index for " + std::to_string(8*sizeof(I)) + "-bit indices");
+    }
+
+    // Sizes come from the file, so each is checked against its length before
+    // it is allocated.
+    in.seekg(0, std::ios::end);
+    const uint64_t remaining = static_cast<uint64_t>(in.tellg()) - sizeof(header);
+    in.seekg(sizeof(header));
+    const uint64_t node_bytes = header.n*sizeof(Node);
+    const uint64_t padded = node_bytes + (-node_bytes % 8);
+    if (header.n > remaining/sizeof(Node) or padded + sizeof(uint64_t) > remaining)
+    {
+        throw std::runtime_error(path + " does not match the sizes in its header");
+    }
+    RhoIndex index;
+    index.nodes.resize(header.n);
+    in.read(reinterpret_cast<char*>(index.nodes.data()), node_bytes);
+    in.ignore(padded - node_bytes);
+    uint64_t cycle_count = 0;
+    in.read(reinterpret_cast<char*>(&cycle_count), sizeof(cycle_count));
+    if (!in or cycle_count > header.n or
+        remaining - padded - sizeof(uint64_t) != 2*sizeof(uint64_t)*cycle_count)
+    {
+        throw std::runtime_error(path + " does not match the sizes in its header");
+    }
+    std::vector<uint64_t> table(1 + 2*cycle_count);
+    table[0] = cycle_count;
+    in.read(reinterpret_cast<char*>(table.data() + 1), 2*cycle_count*sizeof(uint64_t));
+    if (!in or checksum64(table.data(), table.size()*sizeof(uint64_t),
+                          checksum64(index.nodes.data(), node_bytes)) != header.checksum)
+    {
+        throw std::runtime_error(path + " is truncated or corrupt");
+    }
+
+    // Queries index with these unchecked.
+    for (size_t c = 0; c < cycle_count; c++)
+    {
+        uint64_t representative = table[1 + 2*c], length = table[2 + 2*c];
+        if (representative >= header.n or length == 0 or length > header.n)
+        {
+            throw std::runtime_error(path + " has an invalid cycle table");
+        }
+        index.cycles.push_back({static_cast<I>(representative), static_cast<size_t>(length)});
+    }
+    for (const Node& node: index.nodes)
+    {
+        if (static_cast<uint64_t>(node.entry) >= header.n or static_cast<uint64_t>(node.cycle) >= cycle_count)
+        {
+            throw std::runtime_error(path + " has an invalid node record");
+        }
+    }
+    return index;
+}
@@ -0,0 +1,340 @@
+#pragma once
+#include <string>
+#include <span>
+#include <variant>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <stdexcept>
+#include <concepts>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "cycle_detection.hpp"
+#include "binary_format.hpp"
+#include "validation.hpp"
+
+// Hand-off slot of a shared segment. The producer owns it while empty or
+// done/failed, the analyzer while published.
+enum class SharedState : uint32_t
+{
+    empty = 0,
+    published,
+    done,
+    failed
+};
+
+// First 64 bytes of a segment named by shm_open(); the index_width-byte
+// payload of n entries follows directly, 64-byte aligned.
+struct SharedDescriptor
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t index_width;
+    uint32_t reserved;
+    uint64_t n;
+    std::atomic<uint32_t> state;   // SharedState; doubles as the futex word
+    uint32_t padding;
+    uint64_t entry, mu, lambda;    // valid once state is done
+    uint64_t error_index;          // first invalid entry once state is failed
+};
+static_assert(sizeof(SharedDescriptor) == 64);
+static_assert(std::atomic<uint32_t>::is_always_lock_free and sizeof(std::atomic<uint32_t>) == 4);
+
+constexpr char shared_magic[4] = {'T', 'A', 'H', 'S'};
+constexpr uint32_t shared_version = 1;
+
+// Blocks until state is one of the wanted values or the timeout passes, and
+// returns the last state seen. The segment is shared between processes, so
+// this uses a shared futex rather than std::atomic::wait, which libstdc++
+// implements with process-private futexes.
+template <class... States>
+SharedState wait_for_state(const std::atomic<uint32_t>& state, std::chrono::milliseconds timeout, States... wanted)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true)
+    {
+        uint32_t seen = state.load(std::memory_order_acquire);
+        if (((seen == static_cast<uint32_t>(wanted)) or ...))
+        {
+            return static_cast<SharedState>(seen);
+        }
+        auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::nanoseconds(0))
+        {
+            return static_cast<SharedState>(seen);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        timespec wait{static_cast<time_t>(ns/1000000000), static_cast<long>(ns % 1000000000)};
+        ::syscall(SYS_futex, &state, FUTEX_WAIT, seen, &wait, nullptr, 0);
+    }
+}
+
+inline void set_state(std::atomic<uint32_t>& state, SharedState s)
+{
+    state.store(static_cast<uint32_t>(s), std::memory_order_release);
+    ::syscall(SYS_futex, &state, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Read-write mapping of a whole POSIX shared-memory object.
+class SharedSegment
+{
+public:
+    // Creates a new object of `bytes` bytes; fails if the name exists.
+    static SharedSegment create(const std::string& name, size_t bytes)
+    {
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't create shared memory " + name + ": " + std::strerror(errno));
+        }
+        if (::ftruncate(fd, bytes) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("Can't size shared memory " + name);
+        }
+        return SharedSegment(name, fd, bytes, true);
+    }
+
+    static SharedSegment open(const std::string& name)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't open shared memory " + name + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Can't stat shared memory " + name);
+        }
+        return SharedSegment(name, fd, st.st_size, false);
+    }
+
+    SharedSegment(SharedSegment&& other) noexcept:
+        name(std::move(other.name)),
+        base(std::exchange(other.base, nullptr)),
+        length(std::exchange(other.length, 0)),
+        owner(std::exchange(other.owner, false))
+    {}
+    SharedSegment& operator=(SharedSegment&& other) noexcept
+    {
+        std::swap(name, other.name);
+        std::swap(base, other.base);
+        std::swap(length, other.length);
+        std::swap(owner, other.owner);
+        return *this;
+    }
+
+    // The creator removes the name; existing mappings stay valid.
+    ~SharedSegment()
+    {
+        if (base)
+        {
+            ::munmap(base, length);
+        }
+        if (owner)
+        {
+            ::shm_unlink(name.c_str());
+        }
+    }
+
+    void* data() const
+    {
+        return base;
+    }
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    SharedSegment(std::string name, int fd, size_t bytes, bool owner):
+        name(std::move(name)),
+        length(bytes),
+        owner(owner)
+    {
+        if (bytes > 0)
+        {
+            base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (base == MAP_FAILED)
+        {
+            base = nullptr;
+            if (owner)
+            {
+                ::shm_unlink(this->name.c_str());
+            }
+            throw std::runtime_error("Can't map shared memory " + this->name);
+        }
+    }
+
+    std::string name;
+    void* base = nullptr;
+    size_t length = 0;
+    bool owner = false;
+};
+
+// Producer side: fill data<W>() in place, publish(), then wait_result().
+// The segment can be refilled and republished once a result is back.
+class SharedArrayProducer
+{
+public:
+    SharedArrayProducer(const std::string& name, size_t n, uint32_t index_width):
+        segment(SharedSegment::create(name, segment_bytes(n, index_width)))
+    {
+        SharedDescriptor& d = descriptor();
+        std::copy(shared_magic, shared_magic + 4, d.magic);
+        d.version = shared_version;
+        d.index_width = index_width;
+        d.n = n;
+        set_state(d.state, SharedState::empty);
+    }
+
+    template <std::unsigned_integral W>
+    std::span<W> data()
+    {
+        if (sizeof(W) != descriptor().index_width)
+        {
+            throw std::invalid_argument("Segment holds " + std::to_string(descriptor().index_width) +
+                                        "-byte indices");
+        }
+        return {reinterpret_cast<W*>(&descriptor() + 1), descriptor().n};
+    }
+
+    void publish()
+    {
+        set_state(descriptor().state, SharedState::published);
+    }
+
+    // Throws ValidationError if the analyzer rejected the array, and
+    // std::runtime_error if no result arrives in time.
+    RhoResult<uint64_t> wait_result(std::chrono::milliseconds timeout = std::chrono::hours(24))
+    {
+        SharedDescriptor& d = descriptor();
+        SharedState s = wait_for_state(d.state, timeout, SharedState::done, SharedState::failed);
+        if (s == SharedState::failed)
+        {
+            throw ValidationError("Entry " + std::to_string(d.error_index) + " is outside [0, " +
+                                  std::to_string(d.n) + ")", d.error_index);
+        }
+        if (s != SharedState::done)
+        {
+            throw std::runtime_error("No analyzer result within the timeout");
+        }
+        RhoResult<uint64_t> r{};
+        r.entry = d.entry;
+        r.mu = d.mu;
+        r.lambda = d.lambda;
+        return r;
+    }
+
+private:
+    // Checked before the segment is created, so a bad request leaves no name
+    // behind.
+    static size_t segment_bytes(size_t n, uint32_t index_width)
+    {
+        if (index_width != 1 and index_width != 2 and index_width != 4 and index_width != 8)
+        {
+            throw std::invalid_argument("Index width must be 1, 2, 4 or 8 bytes");
+        }
+        if (n == 0)
+        {
+            throw std::invalid_argument("A shared array needs at least one entry");
+        }
+        if (n > (SIZE_MAX - sizeof(SharedDescriptor))/index_width)
+        {
+            throw std::invalid_argument("A shared array of " + std::to_string(n) + " entries does not fit in memory");
+        }
+        return sizeof(SharedDescriptor) + n*index_width;
+    }
+
+    SharedDescriptor& descriptor()
+    {
+        return *static_cast<SharedDescriptor*>(segment.data());
+    }
+
+    SharedSegment segment;
+};
+
+// Analyzer side: runs the chase directly over the producer's pages.
+class SharedArrayAnalyzer
+{
+public:
+    explicit SharedArrayAnalyzer(const std::string& name):
+        segment(SharedSegment::open(name))
+    {
+        const SharedDescriptor& d = descriptor();
+        size_t width = segment.size() >= sizeof(SharedDescriptor) ? d.index_width : 0;
+        if (width == 0 or !std::equal(d.magic, d.magic + 4, shared_magic) or d.version != shared_version or
+            (width != 1 and width != 2 and width != 4 and width != 8) or
+            (segment.size() - sizeof(SharedDescriptor))/width < d.n)
+        {
+            throw std::runtime_error(name + " is not a shared successor array");
+        }
+        if (d.n == 0)
+        {
+            throw std::runtime_error(name + " holds no entries");
+        }
+    }
+
+    // Waits for the next publish and answers it. Returns false on timeout.
+    template <class Engine = Brent>
+    bool serve_once(std::chrono::milliseconds timeout = std::chrono::hours(24))
+    {
+        SharedDescriptor& d = descriptor();
+        if (wait_for_state(d.state, timeout, SharedState::published) != SharedState::published)
+        {
+            return false;
+        }
+        std::visit([&](auto v)
+        {
+            size_t bad = find_invalid_index(v);
+            if (bad != v.size() or v.empty())
+            {
+                d.error_index = bad;
+                set_state(d.state, SharedState::failed);
+                return;
+            }
+            auto r = detect_cycle<Engine>(v);
+            d.entry = r.entry;
+            d.mu = r.mu;
+            d.lambda = r.lambda;
+            set_state(d.state, SharedState::done);
+        }, view());
+        return true;
+    }
+
+    IndexView view() const
+    {
+        const SharedDescriptor& d = descriptor();
+        const void* payload = &d + 1;
+        switch (d.index_width)
+        {
+            case 1: return std::span(static_cast<const uint8_t*>(payload), d.n);
+            case 2: return std::span(static_cast<const uint16_t*>(payload), d.n);
+            case 4: return std::span(static_cast<const uint32_t*>(payload), d.n);
+            default: return std::span(static_cast<const uint64_t*>(payload), d.n);
+        }
+    }
+
+private:
+    SharedDescriptor& descriptor() const
+    {
+        return *static_cast<SharedDescriptor*>(segment.data());
+    }
+
+    SharedSegment segment;
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <charconv>
+#include <concepts>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+#include "mapped_file.hpp"
+#include "work_stealing_pool.hpp"
+
+class ParseError : public std::runtime_error
+{
+public:
+    ParseError(const std::string& what, size_t offset):
+        std::runtime_error(what + " at byte " + std::to_string(offset)),
+        byte_offset(offset)
+    {}
+
+    size_t offset() const
+    {
+        return byte_offset;
+    }
+
+private:
+    size_t byte_offset;
+};
+
+// Tokens are separated by any run of commas and whitespace, so trailing
+// commas, blank lines and "1, 2,\n3" style layouts are all accepted.
+inline bool is_separator(char c)
+{
+    return c == ',' or c == ' ' or c == '\n' or c == '\r' or c == '\t';
+}
+
+// A token starts wherever a separator is followed by anything else.
+inline size_t count_tokens(std::string_view text)
+{
+    size_t tokens = 0;
+    bool previous_separator = true;
+    for (char c: text)
+    {
+        bool separator = is_separator(c);
+        tokens += previous_separator and !separator;
+        previous_separator = separator;
+    }
+    return tokens;
+}
+
+// Parses every token of text[begin, end) into out, which has room for them.
+// Returns the offset of the first malformed token, or npos.
+template <std::integral I>
+size_t parse_tokens(std::string_view text, size_t begin, size_t end, I* out)
+{
+    const char* p = text.data() + begin;
+    const char* last = text.data() + end;
+    while (true)
+    {
+        while (p != last and is_separator(*p))
+        {
+            p++;
+        }
+        if (p == last)
+        {
+            return std::string_view::npos;
+        }
+        auto [next, error] = std::from_chars(p, last, *out++);
+        if (error != std::errc() or (next != last and !is_separator(*next)))
+        {
+            return p - text.data();
+        }
+        p = next;
+    }
+}
+
+// Splits text into chunks that end on a separator, counts the tokens of every
+// chunk in parallel, and then parses each chunk into its slice of one
+// preallocated vector. Throws ParseError with the byte offset of the first
+// malformed or out-of-range token.
+template <std::integral I>
+std::vector<I> parse_indices(std::string_view text, WorkStealingPool& pool = default_pool(),
+                             size_t chunk_bytes = 1 << 20)
+{
+    std::vector<size_t> bounds{0};
+    while (bounds.back() < text.size())
+    {
+        size_t b = std::min(text.size(), bounds.back() + chunk_bytes);
+        while (b < text.size() and !is_separator(text[b]))
+        {
+            b++;
+        }
+        bounds.push_back(b);
+    }
+    size_t chunks = bounds.size() - 1;
+
+    std::vector<size_t> first(chunks + 1);
+    pool.parallel_for(0, chunks, 1, [&](size_t lo, size_t hi)
+    {
+        for (size_t c = lo; c < hi; c++)
+        {
+            first[c + 1] = count_tokens(text.substr(bounds[c], bounds[c + 1] - bounds[c]));
+        }
+    });
+    for (size_t c = 0; c < chunks; c++)
+    {
+        first[c + 1] += first[c];
+    }
+
+    std::vector<I> v(first[chunks]);
+    std::vector<size_t> errors(chunks, std::string_view::npos);
+    pool.parallel_for(0, chunks, 1, [&](size_t lo, size_t hi)
+    {
+        for (size_t c = lo; c < hi; c++)
+        {
+            errors[c] = parse_tokens(text, bounds[c], bounds[c + 1], v.data() + first[c]);
+        }
+    });
+
+    size_t error = std::string_view::npos;
+    for (size_t e: errors)
+    {
+        error = std::min(error, e);
+    }
+    if (error != std::string_view::npos)
+    {
+        size_t end = error;
+        while (end < text.size() and !is_separator(text[end]))
+        {
+            end++;
+        }
+        throw ParseError("Malformed token '" + std::string(text.substr(error, std::min<size_t>(end - error, 32))) + "'",
+                         error);
+    }
+    return v;
+}
+
+template <std::integral I>
+std::vector<I> load_text_indices(const std::string& path, WorkStealingPool& pool = default_pool())
+{
+    MappedFile file(path, MADV_SEQUENTIAL);
+    return parse_indices<I>(file.text(), pool);
+}
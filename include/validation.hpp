@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "cycle_detection.hpp"
+
+class ValidationError : public std::invalid_argument
+{
+public:
+    ValidationError(const std::string& what, size_t index):
+        std::invalid_argument(what),
+        bad_index(index)
+    {}
+
+    size_t index() const
+    {
+        return bad_index;
+    }
+
+private:
+    size_t bad_index;
+};
+
+// Index of the first entry outside [0, n), or outside [1, n-1] with
+// `leetcode` (index 0 is then never a target, which guarantees that the rho
+// from 0 has a tail and thus a duplicate). Returns v.size() when all are valid.
+//
+// Each block is reduced branch-free with a single unsigned compare per entry,
+// (x - lo) >= (hi - lo), which also catches negative values and which the
+// compiler turns into vector compares. Only a failing block is rescanned.
+template <IndexArray A>
+size_t find_invalid_index(const A& v, bool leetcode = false)
+{
+    using I = typename A::value_type;
+    // At least size_t wide, so a span of n > 2^32 is not truncated.
+    using U = std::common_type_t<std::make_unsigned_t<I>, size_t>;
+    const size_t n = v.size();
+    const size_t block = 4096;
+    const U lo = leetcode ? 1 : 0;
+    const U span = n > lo ? static_cast<U>(n - lo) : 0;
+
+    auto out_of_range = [&](size_t i) -> U
+    {
+        return static_cast<U>(static_cast<U>(v[i]) - lo) >= span;
+    };
+    for (size_t begin = 0; begin < n; begin += block)
+    {
+        U bad = 0;
+        if (begin + block <= n)
+        {
+            // Constant trip count, so even -O2 vectorizes it.
+            for (size_t k = 0; k < block; k++)
+            {
+                bad |= out_of_range(begin + k);
+            }
+        }
+        else
+        {
+            bad = 1;
+        }
+        if (bad)
+        {
+            for (size_t i = begin; i < std::min(n, begin + block); i++)
+            {
+                if (out_of_range(i))
+                {
+                    return i;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// Throws ValidationError unless every entry is a valid index, so the
+// unchecked chase loops can never read out of bounds.
+template <IndexArray A>
+void validate_indices(const A& v, bool leetcode = false)
+{
+    size_t i = find_invalid_index(v, leetcode);
+    if (i != v.size())
+    {
+        std::string range = leetcode ? "[1, " + std::to_string(v.size() - 1) + "]"
+                                     : "[0, " + std::to_string(v.size()) + ")";
+        throw ValidationError("Entry " + std::to_string(i) + " = " + std::to_string(v[i]) +
+                              " is outside " + range, i);
+    }
+}
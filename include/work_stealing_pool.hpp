@@ -0,0 +1,197 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+
+// Fixed set of workers, each owning a deque of tasks. Owners pop from the back,
+// idle workers steal from the front of the others. Threads that wait on a
+// parallel_for help out by running queued tasks, so nesting cannot deadlock.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(size_t n_threads = std::thread::hardware_concurrency()):
+        queues(std::max<size_t>(n_threads, 1))
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            queues[i] = std::make_unique<Queue>();
+        }
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            workers.emplace_back([this, i]{ work(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w: workers)
+        {
+            w.join();
+        }
+    }
+
+    size_t size() const
+    {
+        return queues.size();
+    }
+
+    void submit(std::function<void()> task)
+    {
+        size_t target = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard lock(queues[target]->mutex);
+            queues[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard lock(sleep_mutex);
+            pending++;
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(lo, hi) over [begin, end) split into chunks of at most grain
+    // elements and returns once every chunk is done. The first exception thrown
+    // by a chunk is rethrown here.
+    template <class F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& body)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1)
+        {
+            body(begin, end);
+            return;
+        }
+
+        std::atomic<size_t> remaining = chunks;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        for (size_t c = 0; c < chunks; c++)
+        {
+            size_t lo = begin + c*grain;
+            size_t hi = std::min(end, lo + grain);
+            submit([&, lo, hi]
+            {
+                try
+                {
+                    body(lo, hi);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(error_mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+                remaining.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (!run_one(0))
+            {
+                std::this_thread::yield();
+            }
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Pops from the back of queue `self`, otherwise steals from the front of
+    // the others.
+    bool run_one(size_t self)
+    {
+        std::function<void()> task;
+        for (size_t k = 0; k < queues.size() and !task; k++)
+        {
+            Queue& q = *queues[(self + k) % queues.size()];
+            std::lock_guard lock(q.mutex);
+            if (!q.tasks.empty())
+            {
+                if (k == 0)
+                {
+                    task = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                }
+            }
+        }
+        if (!task)
+        {
+            return false;
+        }
+        {
+            std::lock_guard lock(sleep_mutex);
+            pending--;
+        }
+        task();
+        return true;
+    }
+
+    void work(size_t self)
+    {
+        while (true)
+        {
+            if (run_one(self))
+            {
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex);
+            wake.wait(lock, [this]{ return stopping or pending > 0; });
+            if (stopping and pending == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_queue = 0;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    size_t pending = 0;
+    bool stopping = false;
+};
+
+inline WorkStealingPool& default_pool()
+{
+    static WorkStealingPool pool;
+    return pool;
+}
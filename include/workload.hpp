@@ -0,0 +1,277 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <concepts>
+#include <charconv>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include "work_stealing_pool.hpp"
+#include "binary_format.hpp"
+#include "random.hpp"
+
+// Seeded bijection on [0, size): a four-round Feistel network on the bits
+// needed for size - 1, split into halves that differ by at most one bit, with
+// cycle walking for the values that land outside (at most half of them).
+// Stateless and invertible, so every thread can evaluate it both ways.
+class FeistelPermutation
+{
+public:
+    FeistelPermutation(uint64_t size, uint64_t seed):
+        size(size)
+    {
+        unsigned bits = std::bit_width(size > 1 ? size - 1 : 1);
+        width[0] = bits/2;
+        width[1] = bits - width[0];
+        for (int r = 0; r < rounds; r++)
+        {
+            keys[r] = splitmix64(seed + r);
+        }
+    }
+
+    uint64_t operator()(uint64_t x) const
+    {
+        do
+        {
+            x = encrypt(x);
+        } while (x >= size);
+        return x;
+    }
+    uint64_t inverse(uint64_t x) const
+    {
+        do
+        {
+            x = decrypt(x);
+        } while (x >= size);
+        return x;
+    }
+
+private:
+    static constexpr int rounds = 4;
+
+    static uint64_t mask(unsigned bits)
+    {
+        return (uint64_t(1) << bits) - 1;
+    }
+    // One multiply and a fold of the high bits down: the halves are at most
+    // 32 bits, so every output bit depends on every input bit. A bijection
+    // needs no more; full splitmix64 here doubled the generation time.
+    static uint64_t round_function(uint64_t x, uint64_t key)
+    {
+        uint64_t h = (x ^ key)*0x9e3779b97f4a7c15;
+        return h ^ (h >> 32);
+    }
+    // Round r maps (left, right) of widths (width[r%2], width[1-r%2]) to
+    // (right, left ^ F(right)); the widths swap and come back after 4 rounds.
+    uint64_t encrypt(uint64_t x) const
+    {
+        uint64_t left = x >> width[1], right = x & mask(width[1]);
+        for (int r = 0; r < rounds; r++)
+        {
+            uint64_t mixed = left ^ (round_function(right, keys[r]) & mask(width[r % 2]));
+            left = right;
+            right = mixed;
+        }
+        return (left << width[1]) | right;
+    }
+    uint64_t decrypt(uint64_t x) const
+    {
+        uint64_t left = x >> width[1], right = x & mask(width[1]);
+        for (int r = rounds - 1; r >= 0; r--)
+        {
+            uint64_t original = right ^ (round_function(left, keys[r]) & mask(width[r % 2]));
+            right = left;
+            left = original;
+        }
+        return (left << width[1]) | right;
+    }
+
+    uint64_t size;
+    unsigned width[2];   // bits of the left and right half
+    uint64_t keys[rounds];
+};
+
+// Shape of a generated successor array. Every field is met exactly:
+//  - the rho from node 0 has tail mu and cycle lambda,
+//  - there are `components` weakly connected components, the extra ones
+//    being cycles of other_lambda nodes,
+//  - `duplicates` distinct values have more than one preimage.
+// Nodes not needed for that hang off as one long chain.
+struct WorkloadSpec
+{
+    size_t n;
+    size_t mu;
+    size_t lambda;
+    size_t components = 1;
+    size_t other_lambda = 1;
+    size_t duplicates = 1;   // at least 1 when mu > 0: the cycle entry
+    uint64_t seed = 0;
+};
+
+// The array is laid out over positions first and every position p is then
+// relabelled to a node by a random permutation that keeps 0 fixed:
+//   [0, mu + lambda)    the rho from 0
+//   [.., + extra*other) the extra cycles
+//   [.., + branches)    single nodes pointing at distinct in-degree-1 nodes,
+//                       one extra duplicate each
+//   [.., + 2*pairs)     pairs of nodes pointing at the same node, which makes
+//                       it a duplicate: the first pair at an anchor (the first
+//                       branch, or node 0), each further pair at the first
+//                       node of the pair before
+//   [.., n)             a chain ending in a node of in-degree 0
+// A duplicate costs one node off the cycles while in-degree-1 nodes are left
+// and two after that, which is also the least any graph needs, so every
+// feasible spec is generated.
+// Each node x computes its own entry through the inverse permutation, so the
+// fill is parallel, writes sequentially, and depends only on the spec.
+template <std::integral I>
+std::vector<I> generate_workload(const WorkloadSpec& s, WorkStealingPool& pool = default_pool())
+{
+    auto fail = [](const std::string& why)
+    {
+        throw std::invalid_argument("Impossible workload: " + why);
+    };
+    const size_t rho = s.mu + s.lambda;
+    if (s.lambda == 0 or rho > s.n)
+    {
+        fail("need 1 <= lambda and mu + lambda <= n");
+    }
+    if (s.components == 0 or s.other_lambda == 0)
+    {
+        fail("components and other_lambda must be positive");
+    }
+    const size_t extra = s.components - 1;
+    const size_t cycles_end = rho + extra*s.other_lambda;
+    if (extra > (s.n - rho)/s.other_lambda)
+    {
+        fail("the extra cycles don't fit in n");
+    }
+    const size_t entry_duplicates = s.mu > 0;
+    if (s.duplicates < entry_duplicates)
+    {
+        fail("a tail always makes its cycle entry a duplicate");
+    }
+    const size_t wanted = s.duplicates - entry_duplicates;
+    const size_t free_nodes = s.n - cycles_end;
+    // In-degree-1 nodes that a branch can turn into a duplicate: everything
+    // on a cycle or tail except node 0 and the entry in front of a tail.
+    const size_t targets = cycles_end - 2*entry_duplicates;
+    const size_t branches = std::min(wanted, targets);
+    const size_t pairs = wanted - branches;
+    if (branches > free_nodes or pairs > (free_nodes - branches)/2)
+    {
+        fail("too many duplicates for the remaining nodes");
+    }
+    const size_t pairs_begin = cycles_end + branches;
+    const size_t chain_begin = pairs_begin + 2*pairs;
+    // Without a tail every cycle node already has in-degree 1, so the
+    // leftover nodes need a branch or pair to hang off.
+    if (chain_begin < s.n and s.mu == 0 and wanted == 0)
+    {
+        fail("leftover nodes would add a duplicate; use mu > 0 or more duplicates");
+    }
+    const size_t anchor = branches > 0 ? cycles_end : 0;
+    // The chain ends in a node of in-degree 0: node 0 in front of a tail
+    // while no pair points at it, else the last branch or pair node.
+    const size_t sink = s.mu > 0 and (pairs == 0 or anchor != 0) ? 0 : chain_begin - 1;
+
+    auto target = [&](size_t t)
+    {
+        if (s.mu == 0)
+        {
+            return t;
+        }
+        size_t p = t + 1;
+        return p >= s.mu ? p + 1 : p;
+    };
+    auto successor = [&](size_t p) -> size_t
+    {
+        if (p < rho)
+        {
+            return p + 1 < rho ? p + 1 : s.mu;
+        }
+        if (p < cycles_end)
+        {
+            size_t offset = (p - rho) % s.other_lambda;
+            return offset + 1 < s.other_lambda ? p + 1 : p - offset;
+        }
+        if (p < pairs_begin)
+        {
+            // Spread over all targets rather than bunched at the front.
+            return target((p - cycles_end)*targets/branches);
+        }
+        if (p < chain_begin)
+        {
+            size_t pair = (p - pairs_begin)/2;
+            return pair == 0 ? anchor : pairs_begin + 2*(pair - 1);
+        }
+        return p + 1 < s.n ? p + 1 : sink;
+    };
+
+    FeistelPermutation permutation(s.n > 1 ? s.n - 1 : 1, s.seed);
+    auto label = [&](size_t p) -> I
+    {
+        return static_cast<I>(p == 0 ? 0 : 1 + permutation(p - 1));
+    };
+    auto position = [&](size_t x) -> size_t
+    {
+        return x == 0 ? 0 : 1 + permutation.inverse(x - 1);
+    };
+
+    std::vector<I> v(s.n);
+    pool.parallel_for(0, s.n, 1 << 16, [&](size_t lo, size_t hi)
+    {
+        for (size_t x = lo; x < hi; x++)
+        {
+            v[x] = label(successor(position(x)));
+        }
+    });
+    return v;
+}
+
+// Same layout as the bundled examples: "a, b, c". Blocks are formatted in
+// parallel and written in order, a batch at a time to bound the memory.
+template <std::integral I>
+void write_text(const std::string& path, const std::vector<I>& v, WorkStealingPool& pool = default_pool())
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("Can't open " + path + " for writing");
+    }
+    constexpr size_t block = 1 << 16;
+    const size_t batch = 4*pool.size()*block;
+    std::vector<std::string> texts;
+    for (size_t begin = 0; begin < v.size(); begin += batch)
+    {
+        size_t end = std::min(v.size(), begin + batch);
+        texts.assign((end - begin + block - 1)/block, {});
+        pool.parallel_for(0, texts.size(), 1, [&](size_t lo, size_t hi)
+        {
+            char digits[24];
+            for (size_t b = lo; b < hi; b++)
+            {
+                std::string& text = texts[b];
+                for (size_t i = begin + b*block; i < std::min(end, begin + (b + 1)*block); i++)
+                {
+                    if (i > 0)
+                    {
+                        text += ", ";
+                    }
+                    text.append(digits, std::to_chars(digits, digits + sizeof(digits), v[i]).ptr);
+                }
+            }
+        });
+        for (const auto& text: texts)
+        {
+            out.write(text.data(), text.size());
+        }
+    }
+    if (!out)
+    {
+        throw std::runtime_error("Failed writing " + path);
+    }
+}
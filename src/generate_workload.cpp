@@ -0,0 +1,57 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include "workload.hpp"
+
+// generate_workload <output> n=... mu=... lambda=... [components=1]
+//                   [other_lambda=1] [duplicates=1] [seed=0]
+// A .txt output is written in the comma-separated text format, anything else
+// in the binary format.
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <output> n=N mu=M lambda=L [components=C] "
+                  << "[other_lambda=K] [duplicates=D] [seed=S]\n";
+        return 1;
+    }
+
+    WorkloadSpec spec{};
+    try
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            std::string arg(argv[i]);
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq);
+            uint64_t value = std::stoull(arg.substr(eq == std::string::npos ? arg.size() : eq + 1));
+            if (key == "n") spec.n = value;
+            else if (key == "mu") spec.mu = value;
+            else if (key == "lambda") spec.lambda = value;
+            else if (key == "components") spec.components = value;
+            else if (key == "other_lambda") spec.other_lambda = value;
+            else if (key == "duplicates") spec.duplicates = value;
+            else if (key == "seed") spec.seed = value;
+            else throw std::invalid_argument("Unknown option " + key);
+        }
+
+        std::string output(argv[1]);
+        bool text = output.size() >= 4 and output.substr(output.size() - 4) == ".txt";
+        if (spec.n <= (uint64_t(1) << 31))
+        {
+            auto v = generate_workload<int32_t>(spec);
+            text ? write_text(output, v) : write_binary(output, v);
+        }
+        else
+        {
+            auto v = generate_workload<int64_t>(spec);
+            text ? write_text(output, v) : write_binary(output, v);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
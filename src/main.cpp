@@ -1,9 +1,95 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <algorithm>
-#include <fstream>
-#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
 #include "TortoiseAndHare.hpp"
+#include "cycle_detection.hpp"
+#include "random.hpp"
+#include "binary_format.hpp"
+#include "text_parser.hpp"
+#include "validation.hpp"
+
+constexpr size_t max_drawn_circles = 1000;
+
+std::string json_escape(const std::string& s)
+{
+    std::string out;
+    for (char c: s)
+    {
+        if (c == '"' or c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// One JSON object per input file on stdout, in argument order:
+//   {"file": "...", "n": 10, "duplicate": 4, "mu": 2, "lambda": 3}
+// or {"file": "...", "error": "..."}. Returns 1 if any file failed.
+// "duplicate" is the value reached twice on the rho from index 0, or null
+// when index 0 lies on its cycle (mu == 0) and that rho repeats no value.
+int run_headless(const std::vector<std::string>& files)
+{
+    int status = 0;
+    for (const auto& file: files)
+    {
+        std::cout << "{\"file\": \"" << json_escape(file) << '"';
+        try
+        {
+            auto require_entries = [&](size_t n)
+            {
+                if (n == 0)
+                {
+                    throw std::runtime_error(file + " has no entries");
+                }
+            };
+            RhoResult<uint64_t> r;
+            size_t n;
+            if (is_binary_file(file))
+            {
+                MappedArray mapped(file);
+                require_entries(n = mapped.size());
+                if (!mapped.verify_checksum())
+                {
+                    throw std::runtime_error(file + " fails its checksum");
+                }
+                std::visit([](auto view){ validate_indices(view); }, mapped.view());
+                r = detect_cycle<Brent>(mapped);
+            }
+            else
+            {
+                auto v = load_text_indices<int64_t>(file);
+                require_entries(n = v.size());
+                validate_indices(v);
+                r = widen_result(detect_cycle<Brent>(v));
+            }
+            std::cout << ", \"n\": " << n << ", \"duplicate\": "
+                      << (r.has_duplicate() ? std::to_string(r.entry) : "null")
+                      << ", \"mu\": " << r.mu << ", \"lambda\": " << r.lambda << "}\n";
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << ", \"error\": \"" << json_escape(e.what()) << "\"}\n";
+            status = 1;
+        }
+    }
+    return status;
+}
 
 void start(TortoiseAndHare tah)
 {
@@ -12,6 +98,12 @@ void start(TortoiseAndHare tah)
 
 int main(int argc, char* argv[])
 {
+    // --headless <file>...: answer from the files alone, never touching SFML.
+    if (argc > 1 and std::string(argv[1]) == "--headless")
+    {
+        return run_headless(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
     sf::Clock clock;
     int n_circles = 6;
     std::vector<int> v;
@@ -26,20 +118,55 @@ int main(int argc, char* argv[])
         }
         catch (std::invalid_argument)
         {
-            std::ifstream in(argument);
-            std::string vector_string;
-            std::getline(in, vector_string);
-            std::stringstream ss(vector_string);
-            for (int i; ss >> i;) {
-                v.push_back(i);
-                if (ss.peek() == ',')
+            // Unreadable or malformed files end here with their diagnostic
+            // (a ParseError names the byte offset) instead of terminating.
+            try
+            {
+                if (is_binary_file(argument))
                 {
-                    ss.ignore();
+                    // Large inputs are answered straight from the mapping;
+                    // only drawable ones are copied out for the visualizer.
+                    MappedArray mapped(argument);
+                    if (!mapped.verify_checksum())
+                    {
+                        throw std::runtime_error(argument + " fails its checksum");
+                    }
+                    if (mapped.size() > max_drawn_circles)
+                    {
+                        std::visit([](auto view){ validate_indices(view); }, mapped.view());
+                        std::cout << find_duplicates(mapped) << '\n';
+                        return 0;
+                    }
+                    std::visit([&](auto view){ v.assign(view.begin(), view.end()); }, mapped.view());
                 }
+                else
+                {
+                    v = load_text_indices<int>(argument);
+                }
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << '\n';
+                return 1;
             }
         } 
     }
 
+    if (v.empty())
+    {
+        std::cerr << "The input has no entries\n";
+        return 1;
+    }
+    try
+    {
+        validate_indices(v);
+    }
+    catch (const ValidationError& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
     size_t width = 800, height = 700;
     float cwidth = width/2.f, cheight = height/2.f;
     sf::RenderWindow window(sf::VideoMode(width, height), "SFML works!");
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <csignal>
+#include "analysis_server.hpp"
+
+AnalysisServer* running_server = nullptr;
+
+void handle_stop(int)
+{
+    if (running_server)
+    {
+        running_server->stop();
+    }
+}
+
+// tah_daemon <socket> <file>...
+// Loads and indexes every file once, then answers QueryRequest frames on the
+// Unix socket until SIGINT or SIGTERM. Array ids are the file positions.
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <socket> <file>...\n";
+        return 1;
+    }
+    try
+    {
+        std::vector<AnalyzedArray> arrays;
+        for (int i = 2; i < argc; i++)
+        {
+            arrays.emplace_back(argv[i]);
+            std::cerr << "array " << i - 2 << ": " << argv[i] << ", " << arrays.back().size() << " nodes\n";
+        }
+
+        AnalysisServer server(argv[1], std::move(arrays));
+        running_server = &server;
+        std::signal(SIGINT, handle_stop);
+        std::signal(SIGTERM, handle_stop);
+        std::signal(SIGPIPE, SIG_IGN);
+        std::cerr << "listening on " << argv[1] << '\n';
+        server.run();
+        running_server = nullptr;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
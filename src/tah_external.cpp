@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include "external_rho.hpp"
+#include "all_duplicates.hpp"
+
+// tah_external <binary file> [memory=MiB] [scratch=dir] [duplicates=file] [check=0|1]
+// Out-of-core rho of node 0 and duplicate counts within a memory budget
+// (default 256 MiB), with scratch files in `scratch` (default the temp
+// directory). duplicates= also writes every duplicated value and its count
+// there as pairs of 64-bit integers. check=1 also chases the mapped file in
+// memory and compares.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <binary file> [memory=MiB] [scratch=dir] [duplicates=file] "
+                  << "[check=0|1]\n";
+        return 1;
+    }
+    try
+    {
+        size_t memory = size_t(256) << 20;
+        std::filesystem::path scratch = std::filesystem::temp_directory_path();
+        std::string duplicates;
+        bool check = false;
+        for (int i = 2; i < argc; i++)
+        {
+            std::string arg(argv[i]);
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq);
+            std::string value = arg.substr(eq == std::string::npos ? arg.size() : eq + 1);
+            if (key == "memory") memory = std::stoull(value) << 20;
+            else if (key == "scratch") scratch = value;
+            else if (key == "duplicates") duplicates = value;
+            else if (key == "check") check = std::stoi(value) != 0;
+            else throw std::invalid_argument("Unknown option " + key);
+        }
+
+        ExternalWorkspace workspace(memory, scratch);
+        auto begin = std::chrono::steady_clock::now();
+        ExternalRhoResult r = external_rho(argv[1], workspace, duplicates);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        std::cout << "entry " << r.entry << ", mu " << r.mu << ", lambda " << r.lambda << '\n'
+                  << r.cycles << " cycles over " << r.cycle_nodes << " nodes, longest tail " << r.max_tail << '\n'
+                  << r.duplicate_values << " duplicated values, " << r.duplicate_entries << " repeated entries\n"
+                  << "read " << (r.io.bytes_read >> 20) << " MiB, wrote " << (r.io.bytes_written >> 20)
+                  << " MiB in " << elapsed.count() << " s\n";
+        if (check)
+        {
+            MappedArray mapped(argv[1]);
+            RhoResult<uint64_t> m = detect_cycle<Brent>(mapped);
+            uint64_t values = 0, entries = 0;
+            std::visit([&](auto v)
+            {
+                for (auto [value, count] : find_all_duplicates(v))
+                {
+                    values++;
+                    entries += count - 1;
+                }
+            }, mapped.view());
+            bool same = m.entry == r.entry and m.mu == r.mu and m.lambda == r.lambda and
+                        values == r.duplicate_values and entries == r.duplicate_entries;
+            std::cout << "in memory: entry " << m.entry << ", mu " << m.mu << ", lambda " << m.lambda
+                      << ", " << values << " duplicated values, " << entries << " repeated entries"
+                      << (same ? " (match)" : " (MISMATCH)") << '\n';
+            return same ? 0 : 2;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include "shared_array.hpp"
+
+std::atomic<bool> stopping = false;
+
+void handle_stop(int)
+{
+    stopping.store(true);
+}
+
+// tah_shm_analyzer <name>
+// Attaches to a segment made by a SharedArrayProducer and answers every
+// publish with the rho from index 0, read in place, until SIGINT or SIGTERM.
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <name>\n";
+        return 1;
+    }
+    std::signal(SIGINT, handle_stop);
+    std::signal(SIGTERM, handle_stop);
+    try
+    {
+        SharedArrayAnalyzer analyzer(argv[1]);
+        size_t answered = 0;
+        while (!stopping.load())
+        {
+            answered += analyzer.serve_once(std::chrono::milliseconds(200));
+        }
+        std::cerr << answered << " arrays analyzed\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}